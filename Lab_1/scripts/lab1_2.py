@@ -26,6 +26,12 @@ def run_comm_test():
                       encoding='utf-8', 
                       check=True)
 
+    # В выводе кроме таблицы есть строки STATS:/PERF: - оставляем только CSV
+    with open(results_file, encoding='utf-8') as f:
+        table = [line for line in f if ',' in line and ':' not in line]
+    with open(results_file, 'w', encoding='utf-8') as f:
+        f.writelines(table)
+
     # Чтение и вывод результатов
     print("\nРезультаты измерений:")
     data = pd.read_csv(results_file)
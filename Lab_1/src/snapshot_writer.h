@@ -0,0 +1,181 @@
+#pragma once
+// Фоновая запись снимков слоёв решения: расчёт отдаёт слой в очередь из двух буферов и идёт дальше,
+// форматирование и запись на диск - в отдельном потоке. Расчёт ждёт, только если оба буфера ещё
+// не записаны (время ожидания учитывается как нескрытый I/O).
+// Форматы:
+//   BINARY - заголовок "LAB1SNAP", int64 N, double h, double tau; затем на снимок:
+//            int64 номер слоя, double t, N значений double (всё в порядке байт машины);
+//   CSV    - "x,t,u" построчно, числа через std::to_chars (кратчайшее точное представление).
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class SnapshotFormat { BINARY, CSV };
+
+class SnapshotWriter {
+    static const int NUM_BUFFERS = 2;
+
+    struct Buffer {
+        int64_t step = 0;
+        std::vector<double> values;
+    };
+
+    std::ofstream out;
+    SnapshotFormat format;
+    int N;
+    double h, tau;
+
+    Buffer buffers[NUM_BUFFERS];
+    std::deque<int> ready; // записать (в порядке поступления)
+    std::deque<int> free_buffers;
+    bool closing = false;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread writer;
+
+    std::vector<char> text; // буфер форматирования CSV (только поток записи)
+    double io_ms = 0;       // работа потока записи: форматирование + запись
+    double stall_ms = 0;    // ожидание свободного буфера в расчёте
+    double drain_ms = 0;    // ожидание дозаписи в close()
+
+    static double since_ms(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void write_header() {
+        if (format == SnapshotFormat::CSV) {
+            out << "x,t,u\n";
+            return;
+        }
+        const int64_t n64 = N;
+        out.write("LAB1SNAP", 8);
+        out.write(reinterpret_cast<const char*>(&n64), sizeof(n64));
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(&tau), sizeof(tau));
+    }
+
+    void append_number(char*& pos, double value) {
+        pos = std::to_chars(pos, text.data() + text.size(), value).ptr;
+    }
+
+    void write_snapshot(const Buffer& b) {
+        const double t = b.step * tau;
+        if (format == SnapshotFormat::BINARY) {
+            out.write(reinterpret_cast<const char*>(&b.step), sizeof(b.step));
+            out.write(reinterpret_cast<const char*>(&t), sizeof(t));
+            out.write(reinterpret_cast<const char*>(b.values.data()), sizeof(double) * b.values.size());
+            return;
+        }
+        // 3 числа по <= 24 символа + 2 запятые + перевод строки
+        text.resize(size_t(N) * 80);
+        char* pos = text.data();
+        char t_text[32];
+        const size_t t_len = std::to_chars(t_text, t_text + sizeof(t_text), t).ptr - t_text;
+        for (int i = 0; i < N; ++i) {
+            append_number(pos, i * h);
+            *pos++ = ',';
+            std::memcpy(pos, t_text, t_len);
+            pos += t_len;
+            *pos++ = ',';
+            append_number(pos, b.values[i]);
+            *pos++ = '\n';
+        }
+        out.write(text.data(), pos - text.data());
+    }
+
+    void writer_loop() {
+        while (true) {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return !ready.empty() || closing; });
+                if (ready.empty()) break; // closing и всё записано
+                index = ready.front();
+                ready.pop_front();
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            write_snapshot(buffers[index]);
+            io_ms += since_ms(start);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                free_buffers.push_back(index);
+            }
+            cv.notify_all();
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        out.flush();
+        io_ms += since_ms(start);
+    }
+
+public:
+    // Сводка после close(): hidden - доля I/O, выполненная параллельно с расчётом
+    struct Stats {
+        double io_ms, stall_ms, drain_ms, hidden;
+    };
+
+    SnapshotWriter(const std::string& path, SnapshotFormat format_, int N_, double h_, double tau_)
+        : out(path, std::ios::binary | std::ios::trunc), format(format_), N(N_), h(h_), tau(tau_) {
+        if (!out.is_open()) std::cerr << "Ошибка: не удалось открыть файл " << path << " для записи." << std::endl;
+        for (int b = 0; b < NUM_BUFFERS; ++b) {
+            buffers[b].values.resize(N);
+            free_buffers.push_back(b);
+        }
+        write_header();
+        writer = std::thread(&SnapshotWriter::writer_loop, this);
+    }
+
+    ~SnapshotWriter() { close(); }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Копия слоя step в свободный буфер; ждёт, только если оба буфера заняты
+    void push(int64_t step, const double* layer) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (free_buffers.empty()) {
+                auto start = std::chrono::high_resolution_clock::now();
+                cv.wait(lock, [this] { return !free_buffers.empty(); });
+                stall_ms += since_ms(start);
+            }
+            index = free_buffers.front();
+            free_buffers.pop_front();
+        }
+        buffers[index].step = step;
+        std::memcpy(buffers[index].values.data(), layer, sizeof(double) * N);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ready.push_back(index);
+        }
+        cv.notify_all();
+    }
+
+    // Дописать оставшееся и остановить поток записи
+    Stats close() {
+        if (writer.joinable()) {
+            auto start = std::chrono::high_resolution_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                closing = true;
+            }
+            cv.notify_all();
+            writer.join();
+            out.close();
+            drain_ms = since_ms(start);
+        }
+        const double exposed = stall_ms + drain_ms;
+        const double hidden = io_ms > 0 ? std::max(0.0, std::min(1.0, 1.0 - exposed / io_ms)) : 1.0;
+        return {io_ms, stall_ms, drain_ms, hidden};
+    }
+};
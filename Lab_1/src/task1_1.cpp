@@ -6,6 +6,9 @@
 #include <chrono>      
 #include <fstream>     // write results to file
 #include <string>      
+#include <vector>
+#include "perf_mpi.h" // аппаратные счётчики по областям, вывод всех рангов
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
 
 #ifdef _WIN32
 #include <windows.h>   // чисто для win
@@ -26,59 +29,84 @@ int main(int argc, char* argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank); // ID текущего процесса
     MPI_Comm_size(MPI_COMM_WORLD, &size); // кол-во процессов
 
-    // Общее кол-во точек для алгоритма
-    const long long total_points = (argc > 1) ? std::stoll(argv[1]) : 1000000;
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    bench::Reporter reporter("task1_1", cfg);
+    reporter.set_meta("mpi_ranks", std::to_string(size));
 
-    // Распределение точек по процессам
-    long long points_per_process = total_points / size;
-    long long remainder_points = total_points % size;
-    long long local_num_points = points_per_process + (rank < remainder_points ? 1 : 0);
+    // Общее кол-во точек для алгоритма; можно списком через запятую (развёртка в одном запуске)
+    const std::vector<long long> point_counts = (argc > 1) ? bench::parse_list<long long>(argv[1]) : std::vector<long long>{1000000};
+    if (point_counts.empty()) {
+        if (rank == 0) std::cerr << "Неверный список числа точек: " << argv[1] << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
 
     // Генерация случайных точек(Вихрь Мерсенна)
     std::mt19937_64 rng(static_cast<unsigned long long>(rank) + 12345ULL + static_cast<unsigned long long>(std::chrono::system_clock::now().time_since_epoch().count()));
     std::uniform_real_distribution<double> dist(0.0, 1.0); // Равномерное распределение [0.0, 1.0)
 
-    // Замер времени
-    auto start_time = std::chrono::high_resolution_clock::now();
-
-    // Подсчет точек
-    long long local_inside_circle_count = 0;
-    for (long long i = 0; i < local_num_points; ++i) {
-        double x = dist(rng);
-        double y = dist(rng);
-        if (x * x + y * y <= 1.0) {
-            ++local_inside_circle_count;
-        }
+    //  + write to file pi_result.csv
+    std::ofstream fout;
+    if (rank == 0) {
+        fout.open("pi_result.csv");
+        if (fout.is_open()) fout << "Процессы,Точки,π,Время(с)\n";
+        else std::cerr << "Ошибка: не удалось открыть файл pi_result.csv для записи." << std::endl;
     }
 
-    // Сбор резов с рангом 0
-    long long global_inside_circle_count = 0;
-    MPI_Reduce(&local_inside_circle_count, &global_inside_circle_count, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    for (long long total_points : point_counts) {
+        // Распределение точек по процессам
+        long long points_per_process = total_points / size;
+        long long remainder_points = total_points % size;
+        long long local_num_points = points_per_process + (rank < remainder_points ? 1 : 0);
 
-    // вывод
-    if (rank == 0) {
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-        double duration_s = duration_ms.count() / 1000.0;
-
-        // Пи: 4 * (точки в круге / всего точек)
-        double pi_estimate = (total_points > 0) ? (4.0 * global_inside_circle_count / total_points) : 0.0;
-
-        std::cout << "π ≈ " << pi_estimate << std::endl;
-        std::cout << "Точки: " << total_points << std::endl;
-        std::cout << "Процессы: " << size << std::endl;
-        std::cout << "Время: " << duration_s << " с" << std::endl;
-
-        //  + write to file pi_result.csv
-        std::ofstream fout("pi_result.csv");
-        if (fout.is_open()) {
-            fout << "Процессы,Точки,π,Время(с)\n";
-            fout << size << "," << total_points << "," << pi_estimate << "," << duration_s << std::endl;
-            fout.close();
-        } else {
-            std::cerr << "Ошибка: не удалось открыть файл pi_result.csv для записи." << std::endl;
+        long long global_inside_circle_count = 0;
+        const bench::Params params = {{"points", std::to_string(total_points)}, {"ranks", std::to_string(size)}};
+        auto samples = bench::run(cfg, [&] {
+            MPI_Barrier(MPI_COMM_WORLD); // все ранги стартуют вместе
+            // Замер времени
+            auto start_time = std::chrono::high_resolution_clock::now();
+
+            // Подсчет точек
+            long long local_inside_circle_count = 0;
+            {
+                perf::Region region("monte_carlo");
+                for (long long i = 0; i < local_num_points; ++i) {
+                    double x = dist(rng);
+                    double y = dist(rng);
+                    if (x * x + y * y <= 1.0) {
+                        ++local_inside_circle_count;
+                    }
+                }
+            }
+
+            // Сбор резов с рангом 0
+            MPI_Reduce(&local_inside_circle_count, &global_inside_circle_count, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+            // Время запуска - по самому медленному рангу
+            double local_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+            double max_ms = 0;
+            MPI_Allreduce(&local_ms, &max_ms, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            return max_ms;
+        }, params);
+
+        // вывод (время - медиана повторов)
+        if (rank == 0) {
+            double duration_s = reporter.add("monte_carlo", params, samples).median / 1000.0;
+
+            // Пи: 4 * (точки в круге / всего точек)
+            double pi_estimate = (total_points > 0) ? (4.0 * global_inside_circle_count / total_points) : 0.0;
+
+            std::cout << "π ≈ " << pi_estimate << std::endl;
+            std::cout << "Точки: " << total_points << std::endl;
+            std::cout << "Процессы: " << size << std::endl;
+            std::cout << "Время: " << duration_s << " с" << std::endl;
+
+            if (fout.is_open()) fout << size << "," << total_points << "," << pi_estimate << "," << duration_s << std::endl;
         }
     }
+    if (rank == 0) reporter.write();
+
+    perf::report_ordered(MPI_COMM_WORLD); // счётчики всех рангов по порядку
 
     MPI_Finalize();
     return 0;
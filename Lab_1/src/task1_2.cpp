@@ -2,6 +2,9 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <string>
+#include "perf_mpi.h" // аппаратные счётчики по областям, вывод всех рангов
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -27,6 +30,9 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    bench::Reporter reporter("task1_2", cfg);
+
     // Размеры сообщений для тестирования
     const std::vector<int> sizes = {1, 10, 100, 1000, 10000, 100000, 1000000};
     // Усреднение
@@ -38,30 +44,38 @@ int main(int argc, char* argv[]) {
 // Основной цикл: Итерация по размерам сообщений
     for (int size : sizes) {
         std::vector<char> buffer(size);
-        double total_time = 0.0;
-
+        const bench::Params params = {{"bytes", std::to_string(size)}};
 
-// Цикл измерений (повторения для усреднения)
-        for (int i = 0; i < iterations; ++i) {
-            MPI_Barrier(MPI_COMM_WORLD); // синхронизация
-    // Засекаем время начала раунда пинг-понг.
-            auto start = std::chrono::high_resolution_clock::now();
-    // Сам пинг-понг
-            if (rank == 0) {
-                MPI_Send(buffer.data(), size, MPI_BYTE, 1, 0, MPI_COMM_WORLD);
-                MPI_Recv(buffer.data(), size, MPI_BYTE, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            } else {
-                MPI_Recv(buffer.data(), size, MPI_BYTE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                MPI_Send(buffer.data(), size, MPI_BYTE, 0, 0, MPI_COMM_WORLD);
+// Один повтор: среднее время в одну сторону по iterations пинг-понгам (мкс)
+        auto samples = bench::run(cfg, [&] {
+            perf::Region region("ping_pong");
+            double total_time = 0.0;
+            for (int i = 0; i < iterations; ++i) {
+                MPI_Barrier(MPI_COMM_WORLD); // синхронизация
+        // Засекаем время начала раунда пинг-понг.
+                auto start = std::chrono::high_resolution_clock::now();
+        // Сам пинг-понг
+                if (rank == 0) {
+                    MPI_Send(buffer.data(), size, MPI_BYTE, 1, 0, MPI_COMM_WORLD);
+                    MPI_Recv(buffer.data(), size, MPI_BYTE, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                } else {
+                    MPI_Recv(buffer.data(), size, MPI_BYTE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                    MPI_Send(buffer.data(), size, MPI_BYTE, 0, 0, MPI_COMM_WORLD);
+                }
+                total_time += std::chrono::duration<double, std::micro>(
+                    std::chrono::high_resolution_clock::now() - start).count();
             }
-            total_time += std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::high_resolution_clock::now() - start).count();
-        }
+            return total_time / (2 * iterations);
+        }, params);
 
         if (rank == 0) {
-            std::cout << size << "," << total_time / (2 * iterations) << std::endl;
+            double median_us = reporter.add("ping_pong", params, samples, "us").median;
+            std::cout << size << "," << median_us << std::endl;
         }
     }
+    if (rank == 0) reporter.write();
+
+    perf::report_ordered(MPI_COMM_WORLD); // счётчики всех рангов по порядку
 
     MPI_Finalize();
     return 0;
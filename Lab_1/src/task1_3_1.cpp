@@ -1,8 +1,11 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
-#include <fstream>
+#include <string>
 #include <cmath>
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+#include "snapshot_writer.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -35,53 +38,98 @@ double u0(double x) {
     return std::exp(-100 * (x - 0.5) * (x - 0.5));
 }
 
+const int SNAPSHOT_EVERY = 10; // сохраняется каждый 10-й слой
+
 // MAIN
-int main() {
+// task1_3_1 [точек_по_x точек_по_t] [--csv] [--warmup N] [--reps N] ...
+// Снимки пишутся в фоне: sequential_results.bin (по умолчанию) или sequential_results.txt (--csv)
+int main(int argc, char* argv[]) {
 #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
 #endif
-
-    // Параметры сетки сетки
-    const int N = static_cast<int>(L / h) + 1;  // точки по пространству
-    const int M = static_cast<int>(T / tau) + 1; // точки по времени
-
-    // Выделение памяти для решения
-    std::vector<std::vector<double>> u(M, std::vector<double>(N));
-
-    // Начальное условие
-    for (int i = 0; i < N; ++i) {
-        u[0][i] = u0(i * h);
-    }
-    // Start time
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // Решение уравнения переноса
-    for (int n = 0; n < M - 1; ++n) {
-        u[n + 1][0] = 0.0;  // ГУ
-
-        for (int i = 1; i < N - 1; ++i) {
-            u[n + 1][i] = u[n][i] - a * tau / h * (u[n][i] - u[n][i - 1]);
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    SnapshotFormat format = SnapshotFormat::BINARY;
+    std::vector<int> grid_points;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--csv") { format = SnapshotFormat::CSV; continue; }
+        std::vector<int> values = bench::parse_list<int>(argv[i]); // неизвестный флаг или не число - пусто
+        if (values.size() != 1 || grid_points.size() == 2) {
+            std::cerr << "Usage: " << argv[0] << " [points_x points_t] [--csv] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]" << std::endl;
+            return 1;
         }
-
-        u[n + 1][N - 1] = u[n + 1][N - 2];  // ГУ
+        grid_points.push_back(values[0]);
+    }
+    const std::string path = (format == SnapshotFormat::CSV) ? "sequential_results.txt" : "sequential_results.bin";
+
+    // Используем h_ и tau_, чтобы не менять исходные constexpr
+    double h_ = h;
+    double tau_ = tau;
+    if (grid_points.size() >= 2 && grid_points[0] > 1 && grid_points[1] > 1) {
+        h_ = L / (grid_points[0] - 1);
+        tau_ = T / (grid_points[1] - 1);
     }
 
-    // Finish time
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    // Параметры сетки
+    const int N = static_cast<int>(L / h_) + 1;  // точки по пространству
+    const int M = static_cast<int>(T / tau_) + 1; // точки по времени
 
-    // Вывод результатов
-    std::cout << "Сетка: " << N << "x" << M << std::endl;
-    std::cout << "Время: " << duration.count() / 1000.0 << " с" << std::endl;
+    // Только два слоя: текущий и следующий; снимки уходят в поток записи
+    std::vector<double> u_curr(N), u_next(N);
 
-    // Сохранение результатов
-    std::ofstream out("sequential_results.txt");
-    out << "x,t,u\n";
-    for (int n = 0; n < M; n += 10) {
+    const bench::Params params = {{"N", std::to_string(N)}, {"M", std::to_string(M)},
+                                  {"snapshots", format == SnapshotFormat::CSV ? "csv" : "binary"}};
+
+    // Каждый повтор заново считает слои 1..M-1 из одного и того же начального и заново пишет файл
+    bench::Series series = bench::run_multi(cfg, [&] {
+        // Начальное условие
         for (int i = 0; i < N; ++i) {
-            out << i * h << "," << n * tau << "," << u[n][i] << "\n";
+            u_curr[i] = u0(i * h_);
         }
-    }
+        SnapshotWriter writer(path, format, N, h_, tau_);
+
+        // Start time
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Решение уравнения переноса
+        {
+            perf::Region region("solve");
+            writer.push(0, u_curr.data());
+            for (int n = 0; n < M - 1; ++n) {
+                u_next[0] = 0.0;  // ГУ
+
+                for (int i = 1; i < N - 1; ++i) {
+                    u_next[i] = u_curr[i] - a * tau_ / h_ * (u_curr[i] - u_curr[i - 1]);
+                }
+
+                u_next[N - 1] = u_next[N - 2];  // ГУ
+                u_curr.swap(u_next);
+                if ((n + 1) % SNAPSHOT_EVERY == 0) writer.push(n + 1, u_curr.data());
+            }
+        }
+
+        // Finish time: цикл расчёта (вместе с ожиданием свободных буферов), затем дозапись.
+        // Ожидание буферов - это I/O: в solve только расчёт, в io_exposed - ожидание и дозапись
+        double loop_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        SnapshotWriter::Stats io = writer.close();
+        return bench::Metrics{{"solve", loop_ms - io.stall_ms}, {"io", io.io_ms}, {"io_exposed", io.stall_ms + io.drain_ms},
+                              {"io_hidden", 100.0 * io.hidden}, {"total", loop_ms + io.drain_ms}};
+    }, params);
+
+    bench::Reporter reporter("task1_3_1", cfg);
+    double duration_ms = reporter.add("solve", params, series["solve"]).median;
+    double io_ms = reporter.add("io", params, series["io"]).median;
+    double exposed_ms = reporter.add("io_exposed", params, series["io_exposed"]).median;
+    double hidden_pct = reporter.add("io_hidden", params, series["io_hidden"], "%").median;
+    double total_ms = reporter.add("total", params, series["total"]).median;
+
+    // Вывод результатов (время - медиана повторов)
+    std::cout << "Сетка: " << N << "x" << M << std::endl;
+    std::cout << "Время: " << duration_ms / 1000.0 << " с" << std::endl;
+    std::cout << "Запись снимков (" << path << "): " << io_ms / 1000.0 << " с, из них не скрыто "
+              << exposed_ms / 1000.0 << " с, скрыто " << hidden_pct << "%" << std::endl;
+    std::cout << "Всего с записью: " << total_ms / 1000.0 << " с" << std::endl;
+    perf::report(std::cout);
+    reporter.write();
 
     return 0;
-} 
\ No newline at end of file
+}
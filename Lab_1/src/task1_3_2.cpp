@@ -4,6 +4,14 @@
 #include <chrono>
 #include <fstream>
 #include <cmath>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include "perf_mpi.h" // аппаратные счётчики по областям, вывод всех рангов
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+#include "trace_mpi.h" // трасса событий всех рангов (LAB_TRACE)
+#include "transport_solver.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -15,115 +23,322 @@ constexpr double tau = 0.005; // шаг по времени
 constexpr double T = 1.0;  // конечное время
 constexpr double L = 1.0;  // длина области
 
-// НУ
-double u0(double x) {
-    return std::exp(-100 * (x - 0.5) * (x - 0.5));
+// Сетка по числу точек grid_points_x x grid_points_t (0 - исходные h, tau)
+struct Grid {
+    int N, M;          // точек по пространству и по времени
+    double h_, tau_;   // h_ и tau_, чтобы не менять исходные constexpr
+};
+
+Grid make_grid(int grid_points_x, int grid_points_t) {
+    Grid g{0, 0, h, tau};
+    if (grid_points_x > 1 && grid_points_t > 1) {
+        g.h_ = L / (grid_points_x - 1);
+        g.tau_ = T / (grid_points_t - 1);
+    }
+    g.N = static_cast<int>(L / g.h_) + 1;
+    g.M = static_cast<int>(T / g.tau_) + 1;
+    return g;
 }
 
-// MAIN
-int main(int argc, char* argv[]) {
-#ifdef _WIN32
-    SetConsoleOutputCP(CP_UTF8);
-#endif
-    // MPI
-    MPI_Init(&argc, &argv);
+// Параметры записи замеров (и метка областей perf) для одного расчёта
+bench::Params solver_params(const Grid& g, int ranks, HaloMode mode) {
+    return {{"N", std::to_string(g.N)}, {"M", std::to_string(g.M)}, {"ranks", std::to_string(ranks)}, {"halo", halo_mode_name(mode)}};
+}
 
-    int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
+// Повторы расчёта: "solve" - время запуска (мс), "halo_per_step" - обмен на шаг (мкс), оба - по самому медленному рангу
+bench::Series measure_solver(TransportSolver& solver, const bench::Config& cfg, const bench::Params& params) {
+    return bench::run_multi(cfg, [&] {
+        TransportSolver::Times t = solver.run();
+        return bench::Metrics{{"solve", t.total_ms}, {"halo_per_step", t.halo_us_per_step}};
+    }, params);
+}
 
-    // Новые параметры сетки
-    // Используем h_ и tau_, чтобы не менять исходные constexpr
-    double h_ = h;
-    double tau_ = tau;
-    if (argc > 2) {
-        h_ = L / (std::stoi(argv[1]) - 1);
-        tau_ = T / (std::stoi(argv[2]) - 1);
+// Один расчёт на сетке grid_points_x x grid_points_t с повторами, для каждого способа обмена.
+// Последний слой пишется в parallel_results.txt, а при развёртке по нескольким сеткам (per_grid_file) -
+// в parallel_results_<N>x<M>.txt; решение от способа обмена не зависит, пишется один раз
+void run_grid(int grid_points_x, int grid_points_t, const std::vector<HaloMode>& modes, int rank, int size,
+              bool per_grid_file, const bench::Config& cfg, bench::Reporter& reporter) {
+    const Grid g = make_grid(grid_points_x, grid_points_t);
+    const int N = g.N, M = g.M;
+    const double h_ = g.h_;
+
+    for (HaloMode mode : modes) {
+        TransportSolver solver(MPI_COMM_WORLD, N, M, h_, g.tau_, a, mode);
+        const bench::Params params = solver_params(g, size, mode);
+
+        // Каждый повтор заново считает слои 1..M-1
+        bench::Series series = measure_solver(solver, cfg, params);
+
+        // Сбор результатов на нулевом процессе
+        std::vector<double> global_solution = solver.gather(0);
+        if (rank == 0) {
+            double duration_ms = reporter.add("solve", params, series["solve"]).median;
+            double halo_us = reporter.add("halo_per_step", params, series["halo_per_step"], "us").median;
+
+            // Вывод результатов (время - медиана повторов)
+            std::cout << "Сетка: " << N << "x" << M << std::endl;
+            std::cout << "Процессы: " << size << std::endl;
+            std::cout << "Обмен: " << halo_mode_name(mode) << (mode == HaloMode::SHM && !solver.uses_shared_memory() ? " (нет соседей на узле)" : "")
+                      << ", " << halo_us << " мкс/шаг" << std::endl;
+            std::cout << "Время: " << duration_ms / 1000.0 << " с" << std::endl;
+
+            // Сохранение результатов
+            if (mode != modes.front()) continue;
+            const std::string path = per_grid_file ? "parallel_results_" + std::to_string(N) + "x" + std::to_string(M) + ".txt"
+                                                   : "parallel_results.txt";
+            std::ofstream out(path);
+            out << "x,u\n";
+            for (int i = 0; i < N; ++i) {
+                out << i * h_ << "," << global_solution[i] << "\n";
+            }
+        }
     }
+}
+
+// --- Ансамбль: много конфигураций (N, M, p) за один запуск mpirun ---
+// Ранг 0 - планировщик, остальные - рабочие. Планировщик берёт конфигурации по убыванию p и запускает
+// каждую, как только свободных рабочих хватает (мелкие добирают остаток); группа рабочих получает
+// свой коммуникатор через MPI_Comm_create_group (коллективно только внутри группы), считает
+// с повторами и возвращает замеры через лидера (ранг 0 группы).
+const int TAG_ASSIGN = 1;  // int: id, точек по x, точек по t, ранги группы...
+const int TAG_STOP = 2;
+const int TAG_RESULT = 3;  // double: id, режим, повторов, время (мс) x повторов, обмен (мкс) x повторов
+const int TAG_DONE = 4;    // int: id - ранги группы свободны
 
-    // Параметры сетки
-    const int N = static_cast<int>(L / h_) + 1;  // количество точек по пространству
-    const int M = static_cast<int>(T / tau_) + 1; // количество точек по времени
+// Ожидание сообщения без занятого ядра: блокирующий MPI_Probe в Open MPI крутится в опросе и отнимает
+// процессор у рабочих на том же узле, поэтому между MPI_Iprobe - короткий сон
+const auto ENSEMBLE_POLL = std::chrono::microseconds(100);
 
-    // Распределение точек по процессам
-    const int local_N = N / size + (rank == size - 1 ? N % size : 0);
-    const int start_i = rank * (N / size);
+void wait_message(int source, MPI_Status* status) {
+    int flag = 0;
+    while (true) {
+        MPI_Iprobe(source, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, status);
+        if (flag) return;
+        std::this_thread::sleep_for(ENSEMBLE_POLL);
+    }
+}
 
-    // Выделение памяти для решения
-    std::vector<std::vector<double>> u(M, std::vector<double>(local_N + 2));  // +2 для граничных точек
+struct EnsembleConfig {
+    int grid_points_x, grid_points_t, ranks;
+};
 
-    // Заполнение начального условия
-    for (int i = 0; i < local_N; ++i) {
-        u[0][i + 1] = u0((start_i + i) * h_);
+// Строки "N M p"; пустые строки и всё после # пропускаются
+std::vector<EnsembleConfig> read_ensemble(const std::string& path) {
+    std::vector<EnsembleConfig> configs;
+    std::ifstream in(path);
+    if (!in.is_open()) { std::cerr << "Ошибка: не удалось открыть " << path << std::endl; return configs; }
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        EnsembleConfig c;
+        if (ss >> c.grid_points_x >> c.grid_points_t >> c.ranks) configs.push_back(c);
     }
+    return configs;
+}
 
-    // Start time
-    auto start = std::chrono::high_resolution_clock::now();
+void ensemble_worker(const std::vector<HaloMode>& modes, const bench::Config& cfg) {
+    MPI_Group world_group;
+    MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    while (true) {
+        MPI_Status status;
+        wait_message(0, &status); // свободный рабочий не мешает считающим
+        int count = 0;
+        MPI_Get_count(&status, MPI_INT, &count);
+        std::vector<int> msg(count);
+        MPI_Recv(msg.data(), count, MPI_INT, 0, status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (status.MPI_TAG == TAG_STOP) break;
 
-    // Решение уравнения переноса
-    for (int n = 0; n < M - 1; ++n) {
-        // Обмен граничными точками
-        if (rank > 0) {
-            MPI_Sendrecv(&u[n][1], 1, MPI_DOUBLE, rank - 1, 0,
-                        &u[n][0], 1, MPI_DOUBLE, rank - 1, 0,
-                        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
-        if (rank < size - 1) {
-            MPI_Sendrecv(&u[n][local_N], 1, MPI_DOUBLE, rank + 1, 0,
-                        &u[n][local_N + 1], 1, MPI_DOUBLE, rank + 1, 0,
-                        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        const int id = msg[0];
+        MPI_Group group;
+        MPI_Group_incl(world_group, count - 3, msg.data() + 3, &group);
+        MPI_Comm comm;
+        MPI_Comm_create_group(MPI_COMM_WORLD, group, id, &comm);
+        MPI_Group_free(&group);
+
+        const Grid g = make_grid(msg[1], msg[2]);
+        int group_rank;
+        MPI_Comm_rank(comm, &group_rank);
+        for (HaloMode mode : modes) {
+            TransportSolver solver(comm, g.N, g.M, g.h_, g.tau_, a, mode);
+            bench::Series series = measure_solver(solver, cfg, solver_params(g, count - 3, mode));
+            if (group_rank == 0) {
+                const std::vector<double>& samples = series["solve"];
+                const std::vector<double>& halo_samples = series["halo_per_step"];
+                std::vector<double> result = {double(id), double(static_cast<int>(mode)), double(samples.size())};
+                result.insert(result.end(), samples.begin(), samples.end());
+                result.insert(result.end(), halo_samples.begin(), halo_samples.end());
+                MPI_Send(result.data(), static_cast<int>(result.size()), MPI_DOUBLE, 0, TAG_RESULT, MPI_COMM_WORLD);
+            }
         }
+        MPI_Comm_free(&comm);
+        if (group_rank == 0) MPI_Send(&id, 1, MPI_INT, 0, TAG_DONE, MPI_COMM_WORLD);
+    }
+    MPI_Group_free(&world_group);
+}
 
-        // Граничное условие на левом конце
-        if (rank == 0) {
-            u[n + 1][0] = 0.0;
+void ensemble_scheduler(const std::vector<EnsembleConfig>& configs, int world_size, bench::Reporter& reporter,
+                        const std::string& results_path) {
+    const int workers = world_size - 1;
+    std::vector<int> idle;
+    for (int r = 1; r < world_size; ++r) idle.push_back(r);
+
+    std::vector<int> pending; // индексы конфигураций, по убыванию числа процессов
+    size_t skipped = 0;
+    for (int i = 0; i < static_cast<int>(configs.size()); ++i) {
+        if (configs[i].ranks >= 1 && configs[i].ranks <= workers) {
+            pending.push_back(i);
+        } else {
+            std::cerr << "Пропуск конфигурации " << i << ": процессов " << configs[i].ranks << ", рабочих " << workers << std::endl;
+            ++skipped;
         }
+    }
+    std::stable_sort(pending.begin(), pending.end(), [&](int x, int y) { return configs[x].ranks > configs[y].ranks; });
+
+    std::ofstream out(results_path);
+    out << "N,M,Процессы,Режим,Время(с),CI95(с),Обмен(мкс/шаг),Ранги\n";
+    std::vector<std::vector<int>> members(configs.size());
+    int running = 0;
+    std::cout << "Ансамбль: ранг 0 - планировщик, не считает; рабочих " << workers << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
 
-        // Внутренние точки
-        for (int i = 1; i <= local_N; ++i) {
-            u[n + 1][i] = u[n][i] - a * tau_ / h_ * (u[n][i] - u[n][i - 1]);
+    while (!pending.empty() || running > 0) {
+        // Запускаем всё, что помещается в свободных рабочих
+        for (auto it = pending.begin(); it != pending.end();) {
+            const EnsembleConfig& c = configs[*it];
+            if (c.ranks > static_cast<int>(idle.size())) { ++it; continue; }
+            std::vector<int>& group = members[*it];
+            group.assign(idle.begin(), idle.begin() + c.ranks); // младшие ранги - чаще на одном узле
+            idle.erase(idle.begin(), idle.begin() + c.ranks);
+            std::vector<int> msg = {*it, c.grid_points_x, c.grid_points_t};
+            msg.insert(msg.end(), group.begin(), group.end());
+            for (int r : group) MPI_Send(msg.data(), static_cast<int>(msg.size()), MPI_INT, r, TAG_ASSIGN, MPI_COMM_WORLD);
+            ++running;
+            it = pending.erase(it);
         }
 
-        // ГУ на правом конце
-        if (rank == size - 1) {
-            u[n + 1][local_N + 1] = u[n + 1][local_N];
+        MPI_Status status;
+        wait_message(MPI_ANY_SOURCE, &status);
+        if (status.MPI_TAG == TAG_DONE) {
+            int id;
+            MPI_Recv(&id, 1, MPI_INT, status.MPI_SOURCE, TAG_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            idle.insert(idle.end(), members[id].begin(), members[id].end());
+            std::sort(idle.begin(), idle.end());
+            --running;
+            continue;
         }
+
+        int count = 0;
+        MPI_Get_count(&status, MPI_DOUBLE, &count);
+        std::vector<double> result(count);
+        MPI_Recv(result.data(), count, MPI_DOUBLE, status.MPI_SOURCE, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        const int id = static_cast<int>(result[0]);
+        const HaloMode mode = static_cast<HaloMode>(static_cast<int>(result[1]));
+        const size_t reps = static_cast<size_t>(result[2]);
+        std::vector<double> samples(result.begin() + 3, result.begin() + 3 + reps);
+        std::vector<double> halo_samples(result.begin() + 3 + reps, result.end());
+
+        const EnsembleConfig& c = configs[id];
+        const Grid g = make_grid(c.grid_points_x, c.grid_points_t);
+        const bench::Params params = solver_params(g, c.ranks, mode);
+        bench::Stats st = reporter.add("solve", params, samples);
+        double halo_us = reporter.add("halo_per_step", params, halo_samples, "us").median;
+
+        std::string ranks_text;
+        for (size_t i = 0; i < members[id].size(); ++i) ranks_text += (i ? " " : "") + std::to_string(members[id][i]);
+        std::cout << "Сетка: " << g.N << "x" << g.M << ", процессы: " << c.ranks << ", обмен: " << halo_mode_name(mode)
+                  << ", время: " << st.median / 1000.0 << " с (ранги " << ranks_text << ")" << std::endl;
+        out << g.N << "," << g.M << "," << c.ranks << "," << halo_mode_name(mode) << "," << st.median / 1000.0 << ","
+            << st.ci95 / 1000.0 << "," << halo_us << "," << ranks_text << "\n";
     }
 
-    // Finish time
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
-    // Сбор результатов на нулевом процессе
-    if (rank == 0) {
-        std::vector<double> global_solution(N);
-        
-        // Копируем локальное решение
-        for (int i = 0; i < local_N; ++i) {
-            global_solution[i] = u[M - 1][i + 1];
-        }
+    for (int r = 1; r < world_size; ++r) MPI_Send(nullptr, 0, MPI_INT, r, TAG_STOP, MPI_COMM_WORLD);
+    double wall_s = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Ансамбль: " << configs.size() - skipped << " конфигураций (пропущено " << skipped << "), рабочих " << workers << ", общее время: " << wall_s << " с" << std::endl;
+    std::cout << "Результаты: " << results_path << std::endl;
+}
+
+// MAIN
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    // MPI
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-        // Получаем решения от других процессов
-        for (int p = 1; p < size; ++p) {
-            int p_local_N = N / size + (p == size - 1 ? N % size : 0);
-            MPI_Recv(&global_solution[p * (N / size)], p_local_N, MPI_DOUBLE, p, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    bench::Reporter reporter("task1_3_2", cfg);
+    reporter.set_meta("mpi_ranks", std::to_string(size));
+
+    // --halo sendrecv|shm|both: обмен призраками через MPI_Sendrecv или общее окно узла
+    // --ensemble FILE [--ensemble-out CSV]: конфигурации "N M p" из файла за один запуск
+    std::vector<HaloMode> modes = {HaloMode::SENDRECV};
+    std::string ensemble_path, ensemble_out = "ensemble_results.csv";
+    std::string bad_halo;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--ensemble" && i + 1 < argc) {
+            ensemble_path = argv[++i];
+        } else if (arg == "--ensemble-out" && i + 1 < argc) {
+            ensemble_out = argv[++i];
+        } else if (arg == "--halo" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (value == "sendrecv") modes = {HaloMode::SENDRECV};
+            else if (value == "shm") modes = {HaloMode::SHM};
+            else if (value == "both") modes = {HaloMode::SENDRECV, HaloMode::SHM};
+            else bad_halo = value;
+        } else {
+            argv[kept++] = argv[i];
         }
+    }
+    argc = kept;
 
-        // Вывод результатов
-        std::cout << "Сетка: " << N << "x" << M << std::endl;
-        std::cout << "Процессы: " << size << std::endl;
-        std::cout << "Время: " << duration.count() / 1000.0 << " с" << std::endl;
+    if (!bad_halo.empty()) {
+        if (rank == 0) std::cerr << "Неизвестный режим обмена --halo " << bad_halo << " (sendrecv, shm или both)" << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (!ensemble_path.empty() && size < 2) {
+        if (rank == 0) std::cerr << "Ансамблю нужен хотя бы 1 рабочий процесс кроме планировщика (mpirun -n >= 2)" << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
 
-        // Сохранение результатов
-        std::ofstream out("parallel_results.txt");
-        out << "x,u\n";
-        for (int i = 0; i < N; ++i) {
-            out << i * h_ << "," << global_solution[i] << "\n";
+    // Новые параметры сетки: argv[1] - точек по x, argv[2] - по t;
+    // оба могут быть списками через запятую (перебираются все пары)
+    std::vector<int> grid_n = {0}, grid_m = {0}; // 0 - исходные h, tau
+    if (argc > 2) {
+        grid_n = bench::parse_list<int>(argv[1]);
+        grid_m = bench::parse_list<int>(argv[2]);
+        if (grid_n.empty() || grid_m.empty()) {
+            if (rank == 0) std::cerr << "Неверный список точек сетки: " << argv[1] << " " << argv[2] << std::endl;
+            MPI_Finalize();
+            return 1;
         }
+    }
+
+    if (!ensemble_path.empty()) {
+        reporter.set_meta("ensemble", ensemble_path);
+        reporter.set_meta("ensemble_workers", std::to_string(size - 1)); // ранг 0 только планирует
+        if (rank == 0) ensemble_scheduler(read_ensemble(ensemble_path), size, reporter, ensemble_out);
+        else ensemble_worker(modes, cfg);
     } else {
-        // Отправляем локальное решение на нулевой процесс
-        MPI_Send(&u[M - 1][1], local_N, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+        for (int grid_points_x : grid_n) {
+            for (int grid_points_t : grid_m) {
+                run_grid(grid_points_x, grid_points_t, modes, rank, size, grid_n.size() * grid_m.size() > 1, cfg, reporter);
+            }
+        }
     }
+    if (rank == 0) reporter.write();
+    trace::mpi_write(MPI_COMM_WORLD, "task1_3_2");
+
+    perf::report_ordered(MPI_COMM_WORLD); // счётчики всех рангов по порядку
 
     MPI_Finalize();
     return 0;
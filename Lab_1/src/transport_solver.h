@@ -0,0 +1,259 @@
+#pragma once
+// Параллельный решатель уравнения переноса u_t + a * u_x = 0 (левый уголок) на произвольном коммуникаторе.
+// Отрезок [0, L] делится на блоки по рангам comm, у каждого блока ячейки-призраки слева и справа.
+// Обмен призраками (halo) на каждом шаге:
+//   SENDRECV - MPI_Sendrecv с обоими соседями (исходный вариант);
+//   SHM      - ранги одного узла (MPI_Comm_split_type SHARED) держат все слои в окне
+//              MPI_Win_allocate_shared и читают граничное значение соседа напрямую; готовность слоя
+//              сосед публикует атомарным счётчиком в начале своего сегмента. Пары рангов на разных
+//              узлах по-прежнему обмениваются MPI_Sendrecv.
+// Схема противопоточная: на шаге n нужен только u[n] левого соседа, поэтому в SHM ждём только его.
+#include <mpi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "trace.h" // трасса событий (LAB_TRACE)
+
+enum class HaloMode { SENDRECV, SHM };
+
+inline const char* halo_mode_name(HaloMode mode) { return mode == HaloMode::SHM ? "shm" : "sendrecv"; }
+
+// НУ
+inline double transport_u0(double x) {
+    return std::exp(-100 * (x - 0.5) * (x - 0.5));
+}
+
+class TransportSolver {
+    // Заголовок сегмента ранга в общем окне: сколько слоёв готово (сквозной счёт по всем запускам)
+    struct alignas(64) ShmHeader {
+        std::atomic<long long> layers_done;
+    };
+    // Заголовок читают другие процессы узла: атомик должен быть без внутренней блокировки
+    static_assert(std::atomic<long long>::is_always_lock_free, "ShmHeader в общем окне требует lock-free std::atomic<long long>");
+    static const size_t HEADER_BYTES = sizeof(ShmHeader); // ровно строка кэша: слои начинаются со следующей
+    static const size_t SEGMENT_ALIGN = alignof(ShmHeader);
+
+    // Начало заголовка в сегменте: MPI не обязан выравнивать сегменты рангов даже по 8 байтам, поэтому
+    // сегмент берётся с запасом SEGMENT_ALIGN и заголовок сдвигается на границу строки. Окно отображается
+    // постранично, так что сосед по своему адресу сегмента получает тот же сдвиг
+    static char* align_segment(void* base) {
+        const uintptr_t p = reinterpret_cast<uintptr_t>(base);
+        return static_cast<char*>(base) + ((SEGMENT_ALIGN - p % SEGMENT_ALIGN) % SEGMENT_ALIGN);
+    }
+
+    MPI_Comm comm;
+    int rank, size;
+    int N, M;
+    double h, tau, a;
+    HaloMode mode;
+    int local_N, start_i, stride;
+
+    std::vector<double> storage;   // слои в SENDRECV
+    std::vector<double*> u;        // u[n] - слой n (local_N + 2 значений, [0] и [local_N + 1] - призраки)
+
+    // SHM
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    MPI_Win win = MPI_WIN_NULL;
+    ShmHeader* header = nullptr;   // свой сегмент
+    ShmHeader* left_header = nullptr; // сегмент левого соседа, если он на этом узле
+    const double* left_layers = nullptr;
+    int left_stride = 0, left_local_N = 0;
+    bool right_on_node = false;
+    long long layer_base = 0;      // layers_done в начале текущего запуска
+
+    static int block_size(int N_, int size_, int r) { return N_ / size_ + (r == size_ - 1 ? N_ % size_ : 0); }
+
+    // Ранг comm_rank (номер в comm) в node_comm или MPI_UNDEFINED, если он на другом узле
+    int node_rank_of(int comm_rank) const {
+        MPI_Group group, node_group;
+        MPI_Comm_group(comm, &group);
+        MPI_Comm_group(node_comm, &node_group);
+        int node_rank = MPI_UNDEFINED;
+        MPI_Group_translate_ranks(group, 1, &comm_rank, node_group, &node_rank);
+        MPI_Group_free(&group);
+        MPI_Group_free(&node_group);
+        return node_rank;
+    }
+
+    void setup_shared_window() {
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+        const MPI_Aint bytes = static_cast<MPI_Aint>(SEGMENT_ALIGN + HEADER_BYTES + sizeof(double) * size_t(M) * stride);
+        void* base = nullptr;
+        MPI_Info info;
+        MPI_Info_create(&info);
+        MPI_Info_set(info, "alloc_shared_noncontig", "true"); // сегменты рангов не вплотную друг к другу
+        MPI_Win_allocate_shared(bytes, 1, info, node_comm, &base, &win);
+        MPI_Info_free(&info);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, win); // пассивная эпоха на всё время жизни: можно MPI_Win_sync
+
+        char* segment = align_segment(base);
+        header = new (segment) ShmHeader;
+        header->layers_done.store(-1, std::memory_order_relaxed);
+        double* layers = reinterpret_cast<double*>(segment + HEADER_BYTES);
+        for (int n = 0; n < M; ++n) u[n] = layers + size_t(n) * stride;
+        MPI_Win_sync(win);
+        MPI_Barrier(node_comm); // заголовки всех рангов созданы
+
+        if (rank > 0) {
+            int left_node_rank = node_rank_of(rank - 1);
+            if (left_node_rank != MPI_UNDEFINED) {
+                MPI_Aint left_bytes;
+                int disp_unit;
+                void* left_base = nullptr;
+                MPI_Win_shared_query(win, left_node_rank, &left_bytes, &disp_unit, &left_base);
+                char* left_segment = align_segment(left_base);
+                left_header = reinterpret_cast<ShmHeader*>(left_segment);
+                left_layers = reinterpret_cast<const double*>(left_segment + HEADER_BYTES);
+                left_local_N = block_size(N, size, rank - 1);
+                left_stride = left_local_N + 2;
+            }
+        }
+        right_on_node = rank < size - 1 && node_rank_of(rank + 1) != MPI_UNDEFINED;
+    }
+
+    // Призраки слоя n перед шагом n -> n + 1
+    void exchange_halo(int n) {
+        if (left_header) {
+            const long long needed = layer_base + n;
+            while (left_header->layers_done.load(std::memory_order_acquire) < needed) {
+                MPI_Win_sync(win);
+                std::this_thread::yield(); // на переподписанном узле сосед должен успеть посчитать
+            }
+            MPI_Win_sync(win);
+            u[n][0] = left_layers[size_t(n) * left_stride + left_local_N];
+        } else if (rank > 0) {
+            MPI_Sendrecv(&u[n][1], 1, MPI_DOUBLE, rank - 1, 0,
+                         &u[n][0], 1, MPI_DOUBLE, rank - 1, 0,
+                         comm, MPI_STATUS_IGNORE);
+        }
+        // Правый призрак схеме не нужен; через MPI - только ради пары с соседом, который ждёт Sendrecv
+        if (rank < size - 1 && !right_on_node) {
+            MPI_Sendrecv(&u[n][local_N], 1, MPI_DOUBLE, rank + 1, 0,
+                         &u[n][local_N + 1], 1, MPI_DOUBLE, rank + 1, 0,
+                         comm, MPI_STATUS_IGNORE);
+        }
+    }
+
+    void publish_layer(int n) {
+        if (!header) return;
+        MPI_Win_sync(win);
+        header->layers_done.store(layer_base + n, std::memory_order_release);
+    }
+
+public:
+    // Время одного запуска (мс) и среднее время обмена призраками на шаг (мкс), максимум по рангам comm
+    struct Times {
+        double total_ms;
+        double halo_us_per_step;
+    };
+
+    TransportSolver(MPI_Comm comm_, int N_, int M_, double h_, double tau_, double a_, HaloMode mode_)
+        : comm(comm_), N(N_), M(M_), h(h_), tau(tau_), a(a_), mode(mode_) {
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &size);
+        local_N = block_size(N, size, rank);
+        start_i = rank * (N / size);
+        stride = local_N + 2; // +2 для граничных точек
+        u.resize(M);
+
+        if (mode == HaloMode::SHM) {
+            setup_shared_window();
+            for (int n = 0; n < M; ++n) std::fill(u[n], u[n] + stride, 0.0);
+        } else {
+            storage.assign(size_t(M) * stride, 0.0);
+            for (int n = 0; n < M; ++n) u[n] = storage.data() + size_t(n) * stride;
+        }
+
+        // Заполнение начального условия
+        for (int i = 0; i < local_N; ++i) {
+            u[0][i + 1] = transport_u0((start_i + i) * h);
+        }
+        MPI_Barrier(comm);
+    }
+
+    ~TransportSolver() {
+        if (win != MPI_WIN_NULL) {
+            MPI_Win_unlock_all(win);
+            MPI_Win_free(&win);
+        }
+        if (node_comm != MPI_COMM_NULL) MPI_Comm_free(&node_comm);
+    }
+
+    TransportSolver(const TransportSolver&) = delete;
+    TransportSolver& operator=(const TransportSolver&) = delete;
+
+    int rank_in_comm() const { return rank; }
+    int ranks() const { return size; }
+    bool uses_shared_memory() const { return left_header != nullptr || right_on_node; }
+
+    // Один полный расчёт слоёв 1..M-1 (коллективный по comm)
+    Times run() {
+        MPI_Barrier(comm);
+        layer_base += M;
+        publish_layer(0); // начальный слой готов
+        double halo_ms = 0;
+        // Start time
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Решение уравнения переноса
+        {
+            perf::Region region(std::string("solve/") + halo_mode_name(mode));
+            for (int n = 0; n < M - 1; ++n) {
+                // Обмен граничными точками
+                TRACE_BEGIN("halo");
+                auto halo_start = std::chrono::high_resolution_clock::now();
+                exchange_halo(n);
+                halo_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - halo_start).count();
+                TRACE_END("halo");
+
+                TRACE_SCOPE("compute");
+                // Граничное условие на левом конце
+                if (rank == 0) {
+                    u[n + 1][0] = 0.0;
+                }
+
+                // Внутренние точки
+                for (int i = 1; i <= local_N; ++i) {
+                    u[n + 1][i] = u[n][i] - a * tau / h * (u[n][i] - u[n][i - 1]);
+                }
+
+                // ГУ на правом конце
+                if (rank == size - 1) {
+                    u[n + 1][local_N + 1] = u[n + 1][local_N];
+                }
+                publish_layer(n + 1);
+            }
+        }
+
+        // Finish time
+        double local[2] = {std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(),
+                           M > 1 ? halo_ms * 1000.0 / (M - 1) : 0.0};
+        double global[2];
+        MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_MAX, comm);
+        return {global[0], global[1]};
+    }
+
+    // Последний слой целиком на ранге root (на остальных - пустой вектор)
+    std::vector<double> gather(int root = 0) const {
+        std::vector<double> global_solution;
+        if (rank == root) {
+            global_solution.resize(N);
+            for (int p = 0; p < size; ++p) {
+                int p_local_N = block_size(N, size, p);
+                if (p == rank) std::copy(u[M - 1] + 1, u[M - 1] + 1 + local_N, global_solution.begin() + start_i);
+                else MPI_Recv(&global_solution[p * (N / size)], p_local_N, MPI_DOUBLE, p, 0, comm, MPI_STATUS_IGNORE);
+            }
+        } else {
+            // Отправляем локальное решение на нулевой процесс
+            MPI_Send(u[M - 1] + 1, local_N, MPI_DOUBLE, root, 0, comm);
+        }
+        return global_solution;
+    }
+};
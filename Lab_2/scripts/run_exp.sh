@@ -4,7 +4,7 @@
 set -e
 
 # Директории
-BIN_DIR="./bin"
+BUILD_DIR="./build"
 DATA_DIR="./data"
 PLOTS_DIR="./plots" # Хотя этот скрипт не создает графики напрямую
 
@@ -16,8 +16,8 @@ INTEGRAL_RESULTS_FILE="$DATA_DIR/integral_results.txt"
 
 # 1. Сборка проекта
 echo "Building C++ projects..."
-make clean # Очистка перед сборкой (опционально)
-make all
+cmake -S . -B $BUILD_DIR -DCMAKE_BUILD_TYPE=Release
+cmake --build $BUILD_DIR
 echo "Build complete."
 echo ""
 
@@ -26,35 +26,35 @@ mkdir -p $DATA_DIR
 mkdir -p $PLOTS_DIR
 
 # 3. Очистка старых файлов результатов
-rm -f $SORT_RESULTS_FILE $PIPE_RESULTS_FILE $SHARED_MEM_RESULTS_FILE $INTEGRAL_RESULTS_FILE
+rm -f $SORT_RESULTS_FILE $PIPE_RESULTS_FILE $SHARED_MEM_RESULTS_FILE $INTEGRAL_RESULTS_FILE $DATA_DIR/*_stats.json
+
+# Повторы и отбраковка выбросов для всех программ (прогрев, число замеров, K*MAD)
+BENCH_ARGS="--warmup 1 --reps 10 --outliers 3"
 
 echo "Running experiments..."
 echo ""
 
 # --- Эксперименты для сортировки ---
 echo "--- Running Sort Benchmarks ---"
-SIZES_SORT=(100000 500000 1000000 5000000) # Размеры массивов
-THREADS_SORT=(1 2 4 8) # Количество потоков (можно взять реальное число ядер `nproc`)
-                                 # Для 1 потока параллельная сортировка часто работает как std::sort
+SIZES_SORT="100000,500000,1000000,5000000" # Размеры массивов
+THREADS_SORT="1,2,4,8" # Количество потоков (можно взять реальное число ядер `nproc`)
+                       # Для 1 потока параллельная сортировка часто работает как std::sort
 
-for size in "${SIZES_SORT[@]}"; do
-    for threads in "${THREADS_SORT[@]}"; do
-        echo "Sorting: size=$size, threads=$threads"
-        $BIN_DIR/parallel_sort_s $size $threads >> $SORT_RESULTS_FILE
-    done
-done
+# Вся развёртка size x threads - в одном процессе
+echo "Sorting: sizes=$SIZES_SORT, threads=$THREADS_SORT"
+$BUILD_DIR/parallel_sort $SIZES_SORT $THREADS_SORT $BENCH_ARGS --out $DATA_DIR/sort_stats.json >> $SORT_RESULTS_FILE
 echo "Sort benchmarks finished. Results in $SORT_RESULTS_FILE"
 echo ""
 
 # --- Эксперимент для pipe ---
 echo "--- Running Pipe Benchmark ---"
-$BIN_DIR/pipe_benchmark_s > $PIPE_RESULTS_FILE # Перенаправляем весь вывод
+$BUILD_DIR/pipe_benchmark $BENCH_ARGS --out $DATA_DIR/pipe_stats.json > $PIPE_RESULTS_FILE # Перенаправляем весь вывод
 echo "Pipe benchmark finished. Results in $PIPE_RESULTS_FILE"
 echo ""
 
 # --- Эксперимент для shared memory (threads) ---
 echo "--- Running Shared Memory (Threads) Benchmark ---"
-$BIN_DIR/shared_mem_benchmark_s > $SHARED_MEM_RESULTS_FILE # Перенаправляем весь вывод
+$BUILD_DIR/shared_mem_benchmark $BENCH_ARGS --out $DATA_DIR/shared_mem_stats.json > $SHARED_MEM_RESULTS_FILE # Перенаправляем весь вывод
 echo "Shared memory benchmark finished. Results in $SHARED_MEM_RESULTS_FILE"
 echo ""
 
@@ -63,14 +63,11 @@ echo "--- Running Integral Benchmarks ---"
 EPSILON="1e-8"
 A_LIMIT="0.01"
 B_LIMIT="2.0"
-THREADS_INTEGRAL=(1 2 4 8) # Добавьте больше значений, если нужно (например, nproc)
-                            # Убедитесь, что есть замер для 1 потока (базовый)
+THREADS_INTEGRAL="1,2,4,8" # Добавьте больше значений, если нужно (например, nproc)
+                           # Убедитесь, что есть замер для 1 потока (базовый)
 
-echo "Integral params: Epsilon=$EPSILON, A=$A_LIMIT, B=$B_LIMIT"
-for threads in "${THREADS_INTEGRAL[@]}"; do
-    echo "Integrating: threads=$threads"
-    $BIN_DIR/integral_pthread_s $threads $EPSILON $A_LIMIT $B_LIMIT >> $INTEGRAL_RESULTS_FILE
-done
+echo "Integral params: Epsilon=$EPSILON, A=$A_LIMIT, B=$B_LIMIT, threads=$THREADS_INTEGRAL"
+$BUILD_DIR/integral_pthread $THREADS_INTEGRAL $EPSILON $A_LIMIT $B_LIMIT $BENCH_ARGS --out $DATA_DIR/integral_stats.json >> $INTEGRAL_RESULTS_FILE
 echo "Integral benchmarks finished. Results in $INTEGRAL_RESULTS_FILE"
 echo ""
 
@@ -15,6 +15,8 @@ RESULTS_FILES = {
     "sort": DATA_DIR / "sort_results.txt",
     "pipe": DATA_DIR / "pipe_results.txt",
     "shared_mem": DATA_DIR / "shared_mem_results.txt",
+    "shm_ipc": DATA_DIR / "shm_ipc_results.txt",
+    "barrier": DATA_DIR / "barrier_results.txt",
     "integral": DATA_DIR / "integral_results.txt"
 }
 SORT_SIZES = [100000, 500000, 1000000]
@@ -39,6 +41,14 @@ def parse_dp(filepath, prefix, cols, names): # Оставляем как ест
     lines = [l.replace(prefix, "").strip() for l in (filepath.read_text().splitlines() if filepath.exists() else []) if l.startswith(prefix)]
     return pd.read_csv(io.StringIO("\n".join(lines)), sep=" ", header=None, names=names) if lines else pd.DataFrame(columns=names)
 
+def sweep_blocks(stdout, marker):
+    """Делит вывод развёртки внутри одного процесса на блоки по точкам: блок начинается строкой с marker."""
+    blocks = []
+    for line in stdout.splitlines(keepends=True):
+        if line.startswith(marker): blocks.append("")
+        if blocks: blocks[-1] += line
+    return blocks
+
 # --- Функции построения графиков (Изменяем plot_integral_balance) ---
 def plot_sorts(): # Оставляем как есть (тихая версия)
     df = parse_dp(RESULTS_FILES["sort"], "DATAPOINT: ", 5, ["size", "threads", "qsort_ms", "stdsort_ms", "parallel_ms"])
@@ -133,18 +143,22 @@ def main():
     integral_exe_path = exe(integral_exe_name)
 
     # Запуск бенчмарков (максимально тихий режим)
+    # Развёртка размеров и потоков внутри одного процесса; статистика повторов - в *_stats.json
+    sweep = lambda values: ",".join(map(str, values))
     with open(RESULTS_FILES["sort"], "a") as f:
-        for sz in SORT_SIZES:
-            for thr in COMMON_THREADS: f.write(run_cmd([exe("parallel_sort"), str(sz), str(thr)], suppress_output_on_success=True).stdout)
-    for bench in ["pipe", "shared_mem"]:
-        with open(RESULTS_FILES[bench], "w") as f: f.write(run_cmd([exe(f"{bench}_benchmark")], suppress_output_on_success=True).stdout)
+        f.write(run_cmd([exe("parallel_sort"), sweep(SORT_SIZES), sweep(COMMON_THREADS), "--out", str(DATA_DIR / "sort_stats.json")], suppress_output_on_success=True).stdout)
+    for bench in ["pipe", "shared_mem", "shm_ipc", "barrier"]:
+        with open(RESULTS_FILES[bench], "w") as f: f.write(run_cmd([exe(f"{bench}_benchmark"), "--out", str(DATA_DIR / f"{bench}_stats.json")], suppress_output_on_success=True).stdout)
 
+    # Все числа потоков - одним запуском; вывод делится на блоки по точкам развёртки
     last_integral_run_stdout = ""
-    with open(RESULTS_FILES["integral"], "a") as f:
-        for thr in COMMON_THREADS:
-            res = run_cmd([integral_exe_path, str(thr), INTEGRAL_PARAMS["epsilon"], INTEGRAL_PARAMS["a"], INTEGRAL_PARAMS["b"]], suppress_output_on_success=True)
-            f.write(res.stdout)
-            if thr == (COMMON_THREADS[-1] if COMMON_THREADS else 0) and thr > 1: last_integral_run_stdout = res.stdout
+    if COMMON_THREADS:
+        res = run_cmd([integral_exe_path, sweep(COMMON_THREADS), INTEGRAL_PARAMS["epsilon"], INTEGRAL_PARAMS["a"], INTEGRAL_PARAMS["b"],
+                       "--out", str(DATA_DIR / "integral_stats.json")], suppress_output_on_success=True)
+        with open(RESULTS_FILES["integral"], "w") as f: f.write(res.stdout)
+        integral_blocks = sweep_blocks(res.stdout, "Integrating sin(1/x)")
+        if integral_blocks and len(integral_blocks) == len(COMMON_THREADS) and COMMON_THREADS[-1] > 1:
+            last_integral_run_stdout = integral_blocks[-1]
 
     # Построение основных графиков
     plot_sorts()
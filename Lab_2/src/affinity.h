@@ -0,0 +1,251 @@
+#pragma once
+// Привязка потоков к ядрам с учётом топологии (/sys/devices/system/cpu).
+// Режим задаётся переменной окружения LAB_AFFINITY:
+//   none (по умолчанию) - без привязки, решает планировщик;
+//   compact             - плотно: SMT-соседи одного ядра, затем следующие ядра, затем следующий сокет;
+//   scatter             - вразброс: по одному потоку на ядро с чередованием сокетов, SMT-соседи в конце;
+//   0,2,4-7             - явный список CPU.
+// Поток с номером worker получает CPU plan[worker % plan.size()]. Поток, который не удалось
+// привязать, работает без привязки (с предупреждением), и describe() это показывает.
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace affinity {
+
+struct CpuInfo {
+    int cpu;
+    int package; // сокет
+    int core;    // физическое ядро внутри сокета
+};
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}; пустой вектор при ошибке разбора
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        try {
+            size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+            for (int c = first; c <= last; ++c) cpus.push_back(c);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+inline int read_sys_int(const std::string& path, int fallback) {
+    std::ifstream in(path);
+    int value;
+    return (in >> value) ? value : fallback;
+}
+
+// CPU, на которых процессу разрешено работать (online и в маске sched_getaffinity), с топологией
+inline std::vector<CpuInfo> read_topology() {
+    std::vector<CpuInfo> cpus;
+#if defined(__linux__)
+    std::ifstream online_file("/sys/devices/system/cpu/online");
+    std::string online_text;
+    std::getline(online_file, online_text);
+    std::vector<int> online = parse_cpu_list(online_text);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    if (online.empty() && have_mask) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) online.push_back(c);
+    }
+    for (int c : online) {
+        if (have_mask && !CPU_ISSET(c, &allowed)) continue;
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/topology/";
+        cpus.push_back({c, read_sys_int(base + "physical_package_id", 0), read_sys_int(base + "core_id", c)});
+    }
+#endif
+    return cpus;
+}
+
+// Порядок CPU для режима compact
+inline std::vector<int> compact_order(std::vector<CpuInfo> cpus) {
+    std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+        return std::tie(a.package, a.core, a.cpu) < std::tie(b.package, b.core, b.cpu);
+    });
+    std::vector<int> order;
+    for (const auto& c : cpus) order.push_back(c.cpu);
+    return order;
+}
+
+// Порядок CPU для режима scatter: ключ (номер SMT-потока в ядре, номер ядра в сокете, сокет)
+inline std::vector<int> scatter_order(std::vector<CpuInfo> cpus) {
+    std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+        return std::tie(a.package, a.core, a.cpu) < std::tie(b.package, b.core, b.cpu);
+    });
+    std::map<std::pair<int, int>, int> smt_seen;   // (package, core) -> сколько SMT-потоков уже встретили
+    std::map<int, std::map<int, int>> core_rank;   // package -> core_id -> порядковый номер ядра
+    std::vector<std::tuple<int, int, int, int>> keyed;
+    for (const auto& c : cpus) {
+        int smt = smt_seen[{c.package, c.core}]++;
+        auto& ranks = core_rank[c.package];
+        auto rank = ranks.find(c.core);
+        if (rank == ranks.end()) rank = ranks.emplace(c.core, static_cast<int>(ranks.size())).first;
+        keyed.emplace_back(smt, rank->second, c.package, c.cpu);
+    }
+    std::sort(keyed.begin(), keyed.end());
+    std::vector<int> order;
+    for (const auto& k : keyed) order.push_back(std::get<3>(k));
+    return order;
+}
+
+class Placement {
+    std::string mode = "none";
+    std::vector<int> plan; // пусто -> без привязки
+    mutable std::mutex mtx;
+    mutable std::set<size_t> failed; // потоки этого процесса, которые не удалось привязать
+
+    // Общая реакция на неудачную привязку: предупреждение, поток работает без привязки
+    void pin_failed(size_t worker, int error) const {
+        std::cerr << "affinity: cannot pin worker " << worker << " to CPU " << cpu_for(worker) << " ("
+                  << std::strerror(error) << "), running unpinned" << std::endl;
+        std::lock_guard<std::mutex> lock(mtx);
+        failed.insert(worker);
+    }
+
+public:
+    Placement() = default;
+    Placement(std::string mode_, std::vector<int> plan_) : mode(std::move(mode_)), plan(std::move(plan_)) {}
+    Placement(const Placement&) = delete;
+    Placement& operator=(const Placement&) = delete;
+
+    // Разбор значения LAB_AFFINITY (см. начало файла). CPU явного списка, на которых процессу
+    // работать нельзя (нет в read_topology()), отбрасываются с предупреждением
+    static Placement parse(const std::string& spec) {
+        if (spec.empty() || spec == "none") return {};
+        if (spec == "compact") return {"compact", compact_order(read_topology())};
+        if (spec == "scatter") return {"scatter", scatter_order(read_topology())};
+        std::vector<int> list = parse_cpu_list(spec);
+        if (list.empty()) return {"none (bad LAB_AFFINITY='" + spec + "')", {}};
+        const std::vector<CpuInfo> allowed = read_topology();
+        if (!allowed.empty()) {
+            std::vector<int> kept;
+            for (int cpu : list) {
+                bool ok = std::any_of(allowed.begin(), allowed.end(), [cpu](const CpuInfo& c) { return c.cpu == cpu; });
+                if (ok) kept.push_back(cpu);
+                else std::cerr << "affinity: CPU " << cpu << " from LAB_AFFINITY is not available to this process, ignored" << std::endl;
+            }
+            if (kept.empty()) return {"none (no allowed CPUs in LAB_AFFINITY='" + spec + "')", {}};
+            list = kept;
+        }
+        return {"list", list};
+    }
+
+    static Placement from_env() {
+        const char* spec = std::getenv("LAB_AFFINITY");
+        return parse(spec ? spec : "");
+    }
+
+    bool enabled() const { return !plan.empty(); }
+    int cpu_for(size_t worker) const { return enabled() ? plan[worker % plan.size()] : -1; }
+
+    // Все функции привязки при ошибке печатают предупреждение, запоминают поток (см. describe)
+    // и оставляют его без привязки; false - привязки нет
+#if defined(__linux__)
+    // Привязка ещё не запущенного pthread через атрибуты (поток сразу стартует на своём CPU)
+    bool apply_to_attr(pthread_attr_t* attr, size_t worker) const {
+        if (!enabled()) return true;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_for(worker), &set);
+        int error = pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+        if (error != 0) pin_failed(worker, error);
+        return error == 0;
+    }
+
+    // pthread_create с привязкой через атрибуты; если ядро отвергло маску при создании потока
+    // (EINVAL), поток создаётся без привязки. Возвращает код pthread_create
+    int create_thread(pthread_t* thread, size_t worker, void* (*fn)(void*), void* arg) const {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        const bool pinned = enabled() && apply_to_attr(&attr, worker);
+        int error = pthread_create(thread, &attr, fn, arg);
+        pthread_attr_destroy(&attr);
+        if (error == EINVAL && pinned) {
+            pin_failed(worker, error);
+            error = pthread_create(thread, nullptr, fn, arg);
+        }
+        return error;
+    }
+
+    bool pin_thread(pthread_t thread, size_t worker) const {
+        if (!enabled()) return true;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_for(worker), &set);
+        int error = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (error != 0) pin_failed(worker, error);
+        return error == 0;
+    }
+
+    // Вызывать в начале потока, до выделения его данных (first touch)
+    bool pin_self(size_t worker) const { return pin_thread(pthread_self(), worker); }
+#else
+    template <class Attr> bool apply_to_attr(Attr*, size_t) const { return true; }
+    template <class Thread> bool pin_thread(Thread, size_t) const { return true; }
+    bool pin_self(size_t) const { return true; }
+#endif
+
+    // "compact [0,1,2,3]" для первых workers потоков; "-" - поток, который не удалось привязать
+    // (в этом процессе); при нехватке CPU - сколько потоков делят сколько CPU
+    std::string describe(size_t workers) const {
+        std::string text = mode;
+        if (!enabled()) return text;
+        std::lock_guard<std::mutex> lock(mtx);
+        std::set<int> distinct;
+        size_t pinned = 0;
+        text += " [";
+        for (size_t w = 0; w < workers; ++w) {
+            text += w ? "," : "";
+            if (failed.count(w)) { text += "-"; continue; }
+            text += std::to_string(cpu_for(w));
+            distinct.insert(cpu_for(w));
+            ++pinned;
+        }
+        text += "]";
+        if (pinned > distinct.size())
+            text += " (" + std::to_string(pinned) + " workers share " + std::to_string(distinct.size()) + " CPUs)";
+        return text;
+    }
+};
+
+// Аллокатор без value-инициализации: vector<T, DefaultInitAllocator<T>>(n) не трогает страницы,
+// и их физическое размещение определит первый записавший поток (first-touch NUMA policy).
+template <class T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <class U> struct rebind { using other = DefaultInitAllocator<U>; };
+    using std::allocator<T>::allocator;
+    template <class U> void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template <class U, class... Args> void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+};
+
+} // namespace affinity
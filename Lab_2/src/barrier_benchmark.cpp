@@ -0,0 +1,91 @@
+// Замер задержки одного эпизода барьера для разных реализаций и политик ожидания.
+// Каждый поток выполняет только барьеры подряд, так что время эпизода = чистая стоимость синхронизации.
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include "barriers.h"
+#include "affinity.h" // привязка потоков (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+
+const int DEFAULT_EPISODES = 20000; // Эпизодов барьера на одно измерение
+const affinity::Placement placement = affinity::Placement::from_env(); // поток tid -> worker tid
+
+// Среднее время одного эпизода (мкс) для num_threads потоков
+template <class BarrierT>
+double measure_episode_us(size_t num_threads, int episodes) {
+    BarrierT barrier(num_threads);
+    MutexBarrier start_barrier(num_threads + 1); // старт всех потоков одновременно с таймером
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < num_threads; ++tid) {
+        threads.emplace_back([&, tid] {
+            placement.pin_self(tid);
+            start_barrier.wait();
+            perf::Region region("episodes"); // точка (барьер, потоки) и повтор заданы в bench::run
+            for (int e = 0; e < episodes; ++e) barrier.wait(tid);
+        });
+    }
+    start_barrier.wait();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (auto& t : threads) t.join();
+    auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end_time - start_time).count() / episodes;
+}
+
+template <class BarrierT>
+void run_barrier(const std::string& label, size_t num_threads, int episodes, const bench::Config& cfg, bench::Reporter& reporter) {
+    const bench::Params params = {{"barrier", label}, {"threads", std::to_string(num_threads)}};
+    auto samples = bench::run(cfg, [&] { return measure_episode_us<BarrierT>(num_threads, episodes); }, params);
+    double episode_us = reporter.add("episode", params, samples, "us").median;
+    std::cout << "  " << label << ": " << episode_us << " us/episode" << std::endl;
+    // Для Python скрипта
+    std::cout << "DATAPOINT_BARRIER: " << label << " " << num_threads << " " << episode_us << std::endl;
+}
+
+// Все реализации с одной политикой ожидания
+template <class Wait>
+void run_policy(size_t num_threads, int episodes, const bench::Config& cfg, bench::Reporter& reporter) {
+    const std::string suffix = std::string("/") + Wait::name;
+    run_barrier<SenseBarrier<Wait>>(std::string(SenseBarrier<Wait>::name) + suffix, num_threads, episodes, cfg, reporter);
+    run_barrier<DisseminationBarrier<Wait>>(std::string(DisseminationBarrier<Wait>::name) + suffix, num_threads, episodes, cfg, reporter);
+    run_barrier<TreeBarrier<Wait>>(std::string(TreeBarrier<Wait>::name) + suffix, num_threads, episodes, cfg, reporter);
+}
+
+// Запуск: barrier_benchmark [max_threads] [episodes] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]
+int main(int argc, char* argv[]) {
+    bench::Config cfg = bench::parse_args(argc, argv);
+    const size_t hw_threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::vector<size_t> threads_arg = (argc > 1) ? bench::parse_list<size_t>(argv[1]) : std::vector<size_t>{std::max<size_t>(2, hw_threads)};
+    const std::vector<int> episodes_arg = (argc > 2) ? bench::parse_list<int>(argv[2]) : std::vector<int>{DEFAULT_EPISODES};
+    if (threads_arg.size() != 1 || threads_arg[0] == 0 || episodes_arg.size() != 1 || episodes_arg[0] <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [max_threads] [episodes] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]" << std::endl;
+        return 1;
+    }
+    const size_t max_threads = threads_arg[0];
+    const int episodes = episodes_arg[0];
+
+    // 2, 4, 8, ... и обязательно max_threads
+    std::vector<size_t> thread_counts;
+    for (size_t t = 2; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::cout << "Barrier Benchmark: episodes " << episodes << ", hardware threads " << hw_threads << std::endl;
+    bench::Reporter reporter("barrier_benchmark", cfg);
+    reporter.set_meta("episodes", std::to_string(episodes));
+    for (size_t num_threads : thread_counts) {
+        std::cout << "Threads: " << num_threads << ", placement: " << placement.describe(num_threads) << std::endl;
+        run_barrier<MutexBarrier>(MutexBarrier::name, num_threads, episodes, cfg, reporter);
+        // Чистый спин при переподписке ждёт кванта планировщика на каждом эпизоде
+        if (num_threads <= hw_threads) run_policy<wait_policy::BusySpin>(num_threads, episodes, cfg, reporter);
+        else std::cout << "  " << wait_policy::BusySpin::name << ": skipped (threads > hardware threads)" << std::endl;
+        run_policy<wait_policy::SpinYield>(num_threads, episodes, cfg, reporter);
+        run_policy<wait_policy::SpinFutex>(num_threads, episodes, cfg, reporter);
+    }
+    perf::report(std::cout);
+    reporter.set_meta("placement", placement.describe(max_threads)); // после замеров: с учётом неудачных привязок
+    reporter.write();
+    return 0;
+}
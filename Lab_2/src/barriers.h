@@ -0,0 +1,172 @@
+#pragma once
+// Барьеры с единым интерфейсом: конструктор от числа потоков, wait(tid), tid в [0, n).
+//   MutexBarrier          - исходный: mutex + condition_variable, счётчик поколений
+//   SenseBarrier<W>       - централизованный счётчик с обращением смысла (sense reversal)
+//   DisseminationBarrier<W> - распространение: ceil(log2 n) раундов попарных флагов, без общего счётчика
+//   TreeBarrier<W>        - комбинирующее дерево счётчиков (арность TREE_ARITY), корень будит всех
+// W - политика ожидания из wait_policy.h; SpinFutex даёт гибрид "спин, затем блокировка".
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "wait_policy.h"
+
+// Флаг, на котором можно ждать любой политикой: слово + счётчик спящих, на своей кэш-линии
+struct alignas(CACHE_LINE) WaitFlag {
+    std::atomic<uint32_t> word{0};
+    std::atomic<uint32_t> sleepers{0};
+};
+
+// Локальные данные потока, чтобы соседние потоки не делили кэш-линию
+struct alignas(CACHE_LINE) LocalSense {
+    uint32_t sense = 0;
+    uint32_t parity = 0;
+};
+
+// Барьер, чтобы синхронизировать потоки
+class MutexBarrier {
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t count;
+    const size_t initial_count;
+    int generation = 0;
+
+public:
+    static constexpr const char* name = "mutex-condvar";
+// init барьер
+    explicit MutexBarrier(size_t initial_count_) : count(initial_count_), initial_count(initial_count_) {}
+
+    void wait(size_t = 0) {
+        std::unique_lock<std::mutex> lock(mtx);
+        int current_generation = generation;
+        if (--count == 0) {
+            generation++; // Сменить поколение
+            count = initial_count; // Сбросить счетчик для nest step
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return generation != current_generation; });
+        }
+    }
+};
+
+// Централизованный барьер: последний пришедший сбрасывает счётчик и обращает общий смысл
+template <class Wait>
+class SenseBarrier {
+    alignas(CACHE_LINE) std::atomic<size_t> count;
+    const size_t initial_count;
+    WaitFlag sense;
+    std::vector<LocalSense> local;
+
+public:
+    static constexpr const char* name = "central-sense";
+    explicit SenseBarrier(size_t n) : count(n), initial_count(n), local(n) {}
+
+    void wait(size_t tid) {
+        const uint32_t my_sense = local[tid].sense ^= 1u;
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            count.store(initial_count, std::memory_order_relaxed);
+            sense.word.store(my_sense, std::memory_order_release);
+            Wait::wake_all(sense.word, sense.sleepers);
+        } else {
+            while (sense.word.load(std::memory_order_acquire) != my_sense) Wait::wait(sense.word, my_sense ^ 1u, sense.sleepers);
+        }
+    }
+};
+
+// Барьер распространения (Hensgen, Finkel, Manber): в раунде r поток i сигналит потоку (i + 2^r) mod n.
+// Два комплекта флагов (parity) позволяют не сбрасывать флаги между эпизодами.
+template <class Wait>
+class DisseminationBarrier {
+    const size_t n;
+    size_t rounds = 0;
+    std::vector<WaitFlag> flags; // [tid][parity][round]
+    std::vector<LocalSense> local;
+
+    WaitFlag& flag(size_t tid, uint32_t parity, size_t round) { return flags[(tid * 2 + parity) * rounds + round]; }
+
+public:
+    static constexpr const char* name = "dissemination";
+    explicit DisseminationBarrier(size_t n_) : n(n_), local(n_) {
+        while ((size_t(1) << rounds) < n) ++rounds;
+        flags = std::vector<WaitFlag>(n * 2 * (rounds ? rounds : 1));
+        for (auto& l : local) l.sense = 1;
+    }
+
+    void wait(size_t tid) {
+        LocalSense& me = local[tid];
+        for (size_t r = 0; r < rounds; ++r) {
+            WaitFlag& partner = flag((tid + (size_t(1) << r)) % n, me.parity, r);
+            partner.word.store(me.sense, std::memory_order_release);
+            Wait::wake_one(partner.word, partner.sleepers);
+            WaitFlag& mine = flag(tid, me.parity, r);
+            while (mine.word.load(std::memory_order_acquire) != me.sense) Wait::wait(mine.word, me.sense ^ 1u, mine.sleepers);
+        }
+        if (me.parity == 1) me.sense ^= 1u;
+        me.parity ^= 1u;
+    }
+};
+
+const size_t TREE_ARITY = 4;
+
+// Комбинирующее дерево: потоки делятся на группы по TREE_ARITY на листьях,
+// последний пришедший в узел поднимается к родителю; в корне обращается общий смысл.
+template <class Wait>
+class TreeBarrier {
+    struct alignas(CACHE_LINE) Node {
+        std::atomic<size_t> count{0};
+        size_t initial_count = 0;
+        long parent = -1;
+    };
+    std::vector<Node> nodes; // листья первыми, корень последним
+    WaitFlag sense;
+    std::vector<LocalSense> local;
+
+    void arrive(size_t node_index, uint32_t my_sense) {
+        Node& node = nodes[node_index];
+        if (node.count.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        node.count.store(node.initial_count, std::memory_order_relaxed);
+        if (node.parent >= 0) {
+            arrive(static_cast<size_t>(node.parent), my_sense);
+        } else {
+            sense.word.store(my_sense, std::memory_order_release);
+            Wait::wake_all(sense.word, sense.sleepers);
+        }
+    }
+
+public:
+    static constexpr const char* name = "combining-tree";
+    explicit TreeBarrier(size_t n) : local(n) {
+        // Уровни снизу вверх: на уровне из width участников ceil(width / ARITY) узлов
+        std::vector<size_t> level_sizes;
+        size_t width = n;
+        do {
+            width = (width + TREE_ARITY - 1) / TREE_ARITY;
+            level_sizes.push_back(width);
+        } while (width > 1);
+        size_t total = 0;
+        for (size_t s : level_sizes) total += s;
+        nodes = std::vector<Node>(total); // Node не перемещаем (atomic) - создаём сразу нужное число
+
+        size_t members_below = n, level_begin = 0;
+        for (size_t level = 0; level < level_sizes.size(); ++level) {
+            const size_t next_begin = level_begin + level_sizes[level];
+            for (size_t i = 0; i < level_sizes[level]; ++i) {
+                Node& node = nodes[level_begin + i];
+                node.initial_count = std::min(TREE_ARITY, members_below - i * TREE_ARITY);
+                node.count.store(node.initial_count, std::memory_order_relaxed);
+                if (level + 1 < level_sizes.size()) node.parent = static_cast<long>(next_begin + i / TREE_ARITY);
+            }
+            members_below = level_sizes[level];
+            level_begin = next_begin;
+        }
+    }
+
+    void wait(size_t tid) {
+        const uint32_t my_sense = local[tid].sense ^= 1u;
+        arrive(tid / TREE_ARITY, my_sense);
+        while (sense.word.load(std::memory_order_acquire) != my_sense) Wait::wait(sense.word, my_sense ^ 1u, sense.sleepers);
+    }
+};
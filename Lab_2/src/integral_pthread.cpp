@@ -7,6 +7,10 @@
 #include <chrono> // 
 #include <atomic>
 #include <algorithm> // std::max
+#include "affinity.h" // привязка потоков (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+#include "trace.h" // трасса событий (LAB_TRACE)
 
 // --- Глобальные переменные ---
 double func_to_integrate(double x) { if (x == 0.0) return 0.0; return sin(1.0 / x); }
@@ -62,11 +66,16 @@ void* thread_worker(void* arg) {
 
     // Цикл обработки задач
 // ДИНАМИЧЕСКАЯ ОЧЕРЕДЬ
-    while (true) {
-        size_t task_idx = data->next_task_index->fetch_add(1);
-        if (task_idx >= data->tasks_queue->size()) break;
-        const Task& task = (*data->tasks_queue)[task_idx];
-        local_sum += integrate_single_task(data->func, task.a, task.b, task.target_epsilon, local_eval_count);
+    { // области счётчиков и трассы закрываются до pthread_exit (тот не обязан вызывать деструкторы)
+        perf::Region region("thread_worker");
+        TRACE_SCOPE("thread_worker");
+        while (true) {
+            size_t task_idx = data->next_task_index->fetch_add(1);
+            if (task_idx >= data->tasks_queue->size()) break;
+            const Task& task = (*data->tasks_queue)[task_idx];
+            TRACE_SCOPE("task");
+            local_sum += integrate_single_task(data->func, task.a, task.b, task.target_epsilon, local_eval_count);
+        }
     }
 // Замер времени ЭТОГО потока (конец)
     auto thread_end_time = std::chrono::high_resolution_clock::now();
@@ -81,17 +90,16 @@ void* thread_worker(void* arg) {
 }
 
 
-// MAIN
-
-int main(int argc, char* argv[]) {
-// Проверки / input переменные
-    if (argc != 5) { std::cerr << "Usage: " << argv[0] << " <threads> <epsilon> <A> <B>\n"; return 1; }
-    int num_threads = std::stoi(argv[1]); double epsilon_total = std::stod(argv[2]);
-    double A = std::stod(argv[3]); double B = std::stod(argv[4]);
-    if (num_threads <= 0 || epsilon_total <= 0 || A < 0 || B <= A) { std::cerr << "Invalid arguments.\n"; return 1; }
+// Один прогон интегрирования: задачи, потоки, сбор результатов
+struct IntegralRun {
+    double integral = 0.0;
+    long long evaluations = 0;
+    double wall_time_ms = 0.0;
+    std::vector<double> thread_times_ms; // время потоков
+};
 
-    std::cout << "Integrating sin(1/x) from " << A << " to " << B << " with "
-              << num_threads << " threads, epsilon: " << epsilon_total << std::endl;
+IntegralRun run_integral(int num_threads, double epsilon_total, double A, double B, const affinity::Placement& placement) {
+    IntegralRun run;
     auto overall_start_time = std::chrono::high_resolution_clock::now(); // Общее время выполнения
 
 // Подготовка задач
@@ -116,65 +124,103 @@ int main(int argc, char* argv[]) {
     std::vector<ThreadData> thread_data_arr(num_threads);
     std::vector<double> partial_sums(num_threads, 0.0);
     std::vector<int> thread_eval_counts(num_threads, 0);
-    std::vector<double> thread_times_ms(num_threads, 0.0); // время потоков
+    run.thread_times_ms.assign(num_threads, 0.0);
 
     // Запуск рабочих потоков
     for (int i = 0; i < num_threads; ++i) {
         // Добавляем указатель на thread_times_ms[i] в ThreadData
-        thread_data_arr[i] = {&tasks_queue, &next_task_index, &partial_sums[i], &thread_eval_counts[i], func_to_integrate, &thread_times_ms[i]};
-        if (pthread_create(&threads_arr[i], NULL, thread_worker, &thread_data_arr[i])) {
+        thread_data_arr[i] = {&tasks_queue, &next_task_index, &partial_sums[i], &thread_eval_counts[i], func_to_integrate, &run.thread_times_ms[i]};
+        // Привязка через атрибуты: поток стартует сразу на своём CPU, его стек и локальные данные там же
+        if (placement.create_thread(&threads_arr[i], i, thread_worker, &thread_data_arr[i])) {
             std::cerr << "Error creating thread " << i << std::endl; exit(-1);
         }
     }
 
     // Завершение потоков и сбор сумм интеграла
-    double total_integral = 0.0;
     for (int i = 0; i < num_threads; ++i) {
         pthread_join(threads_arr[i], NULL);
-        total_integral += partial_sums[i];
+        run.integral += partial_sums[i];
+        run.evaluations += thread_eval_counts[i]; // Суммируем вычисления
     }
+    run.wall_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - overall_start_time).count();
+    return run;
+}
+
+// MAIN
+// <threads> может быть списком через запятую (1,2,4,8): развёртка внутри одного процесса
+
+int main(int argc, char* argv[]) {
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+// Проверки / input переменные
+    if (argc != 5) { std::cerr << "Usage: " << argv[0] << " <threads[,threads2...]> <epsilon> <A> <B> [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]\n"; return 1; }
+    std::vector<int> thread_counts = bench::parse_list<int>(argv[1]); double epsilon_total = std::stod(argv[2]);
+    double A = std::stod(argv[3]); double B = std::stod(argv[4]);
+    bool bad_threads = thread_counts.empty();
+    for (int t : thread_counts) bad_threads = bad_threads || t <= 0;
+    if (bad_threads || epsilon_total <= 0 || A < 0 || B <= A) { std::cerr << "Invalid arguments.\n"; return 1; }
+
+    const affinity::Placement placement = affinity::Placement::from_env();
+    const int max_threads = *std::max_element(thread_counts.begin(), thread_counts.end());
+    bench::Reporter reporter("integral_pthread", cfg);
+
+    for (int num_threads : thread_counts) {
+        std::cout << "Integrating sin(1/x) from " << A << " to " << B << " with "
+                  << num_threads << " threads, epsilon: " << epsilon_total << std::endl;
+        std::cout << "Placement: " << placement.describe(num_threads) << std::endl;
+
+        IntegralRun last; // балансировка и результат - по последнему повтору
+        const bench::Params params = {{"threads", std::to_string(num_threads)}, {"epsilon", argv[2]}, {"a", argv[3]}, {"b", argv[4]}};
+        auto samples = bench::run(cfg, [&] {
+            last = run_integral(num_threads, epsilon_total, A, B, placement);
+            return last.wall_time_ms;
+        }, params);
+        const double overall_time_ms = reporter.add("integral", params, samples).median;
+        const std::vector<double>& thread_times_ms = last.thread_times_ms;
 
 // Статистика для питона
-    // Сбор статистики по ВРЕМЕНИ выполнения потоков
-    long long total_evals_sum = 0; // Общее число вычислений все еще считаем
-    double sum_thread_time_ms = 0;
-    double min_thread_time_ms = 0, max_thread_time_ms = 0;
-    if (num_threads > 0 && !thread_times_ms.empty()) { // Инициализация min/max
-        min_thread_time_ms = thread_times_ms[0]; max_thread_time_ms = thread_times_ms[0];
-    }
+        // Сбор статистики по ВРЕМЕНИ выполнения потоков
+        double sum_thread_time_ms = 0;
+        double min_thread_time_ms = 0, max_thread_time_ms = 0;
+        if (num_threads > 0 && !thread_times_ms.empty()) { // Инициализация min/max
+            min_thread_time_ms = thread_times_ms[0]; max_thread_time_ms = thread_times_ms[0];
+        }
 
-    for (int i = 0; i < num_threads; ++i) {
-        total_evals_sum += thread_eval_counts[i]; // Суммируем вычисления
-        sum_thread_time_ms += thread_times_ms[i];
-        if (thread_times_ms[i] < min_thread_time_ms) min_thread_time_ms = thread_times_ms[i];
-        if (thread_times_ms[i] > max_thread_time_ms) max_thread_time_ms = thread_times_ms[i];
-        // Вывод для парсинга Python'ом (время потока)
-        std::cout << "THREAD_TIME_MS: " << i << " " << std::fixed << std::setprecision(3) << thread_times_ms[i] << std::endl;
-    }
+        for (int i = 0; i < num_threads; ++i) {
+            sum_thread_time_ms += thread_times_ms[i];
+            if (thread_times_ms[i] < min_thread_time_ms) min_thread_time_ms = thread_times_ms[i];
+            if (thread_times_ms[i] > max_thread_time_ms) max_thread_time_ms = thread_times_ms[i];
+            // Вывод для парсинга Python'ом (время потока)
+            std::cout << "THREAD_TIME_MS: " << i << " " << std::fixed << std::setprecision(3) << thread_times_ms[i] << std::endl;
+        }
 
-    // Вывод статистики балансировки по ВРЕМЕНИ
-    if (num_threads > 1) {
-        double avg_time_ms = (num_threads > 0) ? (sum_thread_time_ms / num_threads) : 0.0;
-        double spread_percentage = (avg_time_ms > 1e-6) ? // Используем мс, порог можно меньше
-                                   ((max_thread_time_ms - min_thread_time_ms) / avg_time_ms) * 100.0
-                                   : 0.0;
-        std::cout << "Load Balancing (Time_ms): Min=" << std::fixed << std::setprecision(3) << min_thread_time_ms
-                  << ", Max=" << std::fixed << std::setprecision(3) << max_thread_time_ms
-                  << ", Avg=" << std::fixed << std::setprecision(3) << avg_time_ms
-                  << ", Spread=" << std::fixed << std::setprecision(2) << spread_percentage << "%" << std::endl;
-    } else if (num_threads == 1) {
-         std::cout << "Load Balancing (Time_ms): N/A for single thread." << std::endl;
-    }
+        // Вывод статистики балансировки по ВРЕМЕНИ
+        if (num_threads > 1) {
+            double avg_time_ms = (num_threads > 0) ? (sum_thread_time_ms / num_threads) : 0.0;
+            double spread_percentage = (avg_time_ms > 1e-6) ? // Используем мс, порог можно меньше
+                                       ((max_thread_time_ms - min_thread_time_ms) / avg_time_ms) * 100.0
+                                       : 0.0;
+            std::cout << "Load Balancing (Time_ms): Min=" << std::fixed << std::setprecision(3) << min_thread_time_ms
+                      << ", Max=" << std::fixed << std::setprecision(3) << max_thread_time_ms
+                      << ", Avg=" << std::fixed << std::setprecision(3) << avg_time_ms
+                      << ", Spread=" << std::fixed << std::setprecision(2) << spread_percentage << "%" << std::endl;
+        } else if (num_threads == 1) {
+             std::cout << "Load Balancing (Time_ms): N/A for single thread." << std::endl;
+        }
 
-    // Завершение общего замера времени и вывод результатов
-    auto overall_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - overall_start_time).count();
-    std::cout << std::fixed << std::setprecision(10) << "Integral result: " << total_integral << std::endl;
-    std::cout << "Total function evaluations: " << total_evals_sum << std::endl; // Оставляем для информации
-    std::cout << "Total Wall Time (" << num_threads << " thr): " << std::fixed << std::setprecision(3) << overall_time_ms << " ms" << std::endl; // Переименовал для ясности
+        // Вывод результатов (время - медиана повторов)
+        std::cout << std::fixed << std::setprecision(10) << "Integral result: " << last.integral << std::endl;
+        std::cout << "Total function evaluations: " << last.evaluations << std::endl; // Оставляем для информации
+        std::cout << "Total Wall Time (" << num_threads << " thr): " << std::fixed << std::setprecision(3) << overall_time_ms << " ms" << std::endl; // Переименовал для ясности
 
-    // Вывод данных для Python-скрипта (используем общее время overall_time_ms)
-    if (num_threads == 1) std::cout << "DATAPOINT_INTEGRAL_SINGLE: " << overall_time_ms << " " << total_evals_sum << std::endl;
-    else std::cout << "DATAPOINT_INTEGRAL_MULTI: " << num_threads << " " << overall_time_ms << " " << total_evals_sum << std::endl;
+        // Вывод данных для Python-скрипта (используем общее время overall_time_ms)
+        if (num_threads == 1) std::cout << "DATAPOINT_INTEGRAL_SINGLE: " << overall_time_ms << " " << last.evaluations << std::endl;
+        else std::cout << "DATAPOINT_INTEGRAL_MULTI: " << num_threads << " " << overall_time_ms << " " << last.evaluations << std::endl;
+        std::cout << std::defaultfloat << std::setprecision(6);
+    }
 
+    perf::report(std::cout);
+    reporter.set_meta("placement", placement.describe(max_threads)); // после замеров: с учётом неудачных привязок
+    reporter.write();
+    trace::write("integral_pthread");
     return 0;
-}
\ No newline at end of file
+}
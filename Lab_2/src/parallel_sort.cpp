@@ -4,6 +4,13 @@
 #include <chrono>    
 #include <thread>    
 #include <random>    // для ген случ числ
+#include "affinity.h" // привязка потоков (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+
+// Размещение потоков: поток i всегда на одном и том же CPU (и при first touch, и при сортировке)
+const affinity::Placement placement = affinity::Placement::from_env();
+using SortVector = std::vector<int, affinity::DefaultInitAllocator<int>>; // без обнуления при создании
 
 // Ген вектор случ чис
 std::vector<int> generate_random_vector(size_t size, int min_val = 0, int max_val = 1000000) {
@@ -15,12 +22,33 @@ std::vector<int> generate_random_vector(size_t size, int min_val = 0, int max_va
 }
 
 // Сортировка в отдельном потоке
-void sort_chunk(std::vector<int>::iterator begin, std::vector<int>::iterator end) {
+void sort_chunk(SortVector::iterator begin, SortVector::iterator end, int worker) {
+    placement.pin_self(worker);
+    perf::Region region("sort_chunk");
     std::sort(begin, end);
 }
 
+// Первое касание: поток i сам копирует свою часть, и её страницы размещаются в его NUMA-узле.
+// Разбиение совпадает с parallel_merge_sort.
+void first_touch_copy(const std::vector<int>& src, SortVector& dst, int num_threads) {
+    if (num_threads <= 0 || src.size() < static_cast<size_t>(num_threads * 2)) {
+        std::copy(src.begin(), src.end(), dst.begin());
+        return;
+    }
+    size_t chunk_size = src.size() / num_threads;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        size_t begin = i * chunk_size, end = (i == num_threads - 1) ? src.size() : begin + chunk_size;
+        threads.emplace_back([&src, &dst, begin, end, i] {
+            placement.pin_self(i);
+            std::copy(src.begin() + begin, src.begin() + end, dst.begin() + begin);
+        });
+    }
+    for (auto& t : threads) t.join();
+}
+
 // Параллельная сортировка слиянием
-void parallel_merge_sort(std::vector<int>& vec, int num_threads) {
+void parallel_merge_sort(SortVector& vec, int num_threads) {
     if (num_threads <= 0 || vec.size() < static_cast<size_t>(num_threads * 2)) {
         std::sort(vec.begin(), vec.end()); // Если мало элементов или потоков, используем std::sort
         return;
@@ -28,14 +56,14 @@ void parallel_merge_sort(std::vector<int>& vec, int num_threads) {
  // хранение потоков + хранение начало/конец
     size_t chunk_size = vec.size() / num_threads; 
     std::vector<std::thread> threads;
-    std::vector<std::pair<std::vector<int>::iterator, std::vector<int>::iterator>> chunks;
+    std::vector<std::pair<SortVector::iterator, SortVector::iterator>> chunks;
 // делим вектор на части
     auto it = vec.begin();
     for (int i = 0; i < num_threads; ++i) {
         auto chunk_end = (i == num_threads - 1) ? vec.end() : (it + chunk_size);
 // Сохраняем пару итераторов (начало 'it', конец 'chunk_end') в вектор 'chunks'.        
         chunks.push_back({it, chunk_end});
-        threads.emplace_back(sort_chunk, it, chunk_end); // Запускаем сортировку частей в потоках
+        threads.emplace_back(sort_chunk, it, chunk_end, i); // Запускаем сортировку частей в потоках
         it = chunk_end;
     }
 
@@ -56,49 +84,84 @@ int compare_ints_qsort(const void* a, const void* b) {
     return 0;
 }
 
+// Время (мс) одного запуска sort_fn над свежей копией данных; копирование в замер не входит
+template <class Vec, class SortFn>
+double time_sort(const char* region_name, Vec& data, SortFn sort_fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    { perf::Region region(region_name); sort_fn(data); }
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
 // MAIN
-// первый аргумент (argv[1]) размер вектора.
+// первый аргумент (argv[1]) размер вектора, второй - число потоков;
+// оба могут быть списками через запятую (развёртка внутри одного процесса): 100000,1000000 1,2,4
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <vector_size> [num_threads]" << std::endl;
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    auto usage = [&] {
+        std::cerr << "Usage: " << argv[0] << " <vector_size[,size2...]> [num_threads[,threads2...]]"
+                  << " [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]" << std::endl;
         return 1;
-    }
+    };
+    if (argc < 2) return usage();
 // Кол-во потоков для сортировки (или равно колыу ядер)
-    size_t vector_size = std::stoul(argv[1]);
-    int num_threads = (argc > 2) ? std::stoi(argv[2]) : std::thread::hardware_concurrency();
-    if (num_threads <= 0) num_threads = 1;
-
-    std::cout << "Vector size: " << vector_size << ", Parallel sort threads: " << num_threads << std::endl;
-
-    std::vector<int> v_orig = generate_random_vector(vector_size);
-    std::vector<int> v_parallel = v_orig;
-    std::vector<int> v_qsort = v_orig;
-    std::vector<int> v_stdsort = v_orig;
-// Генерируем исходный вектор со случайными данными + копируем его для 
-    // std::qsort
-    auto start_q = std::chrono::high_resolution_clock::now();
-    qsort(v_qsort.data(), v_qsort.size(), sizeof(int), compare_ints_qsort);
-    auto qsort_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_q).count();
-    std::cout << "qsort time: " << qsort_time << " ms" << std::endl;
-
-    // std::sort (однопоточный)
-    auto start_std = std::chrono::high_resolution_clock::now();
-    std::sort(v_stdsort.begin(), v_stdsort.end());
-    auto stdsort_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_std).count();
-    std::cout << "std::sort time: " << stdsort_time << " ms" << std::endl;
-
-    // parallel_merge_sort
-    auto start_p = std::chrono::high_resolution_clock::now();
-    parallel_merge_sort(v_parallel, num_threads);
-    auto parallel_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_p).count();
-    std::cout << "Parallel sort time (" << num_threads << " threads): " << parallel_time << " ms" << std::endl;
-
-    // Проверка
-    if (!std::is_sorted(v_parallel.begin(), v_parallel.end())) std::cerr << "Parallel sort FAILED!" << std::endl;
-    if (!std::is_sorted(v_qsort.begin(), v_qsort.end())) std::cerr << "qsort FAILED!" << std::endl;
-
-    // Для Python скрипта
-    std::cout << "DATAPOINT: " << vector_size << " " << num_threads << " "
-              << qsort_time << " " << stdsort_time << " " << parallel_time << std::endl;
+    std::vector<size_t> vector_sizes = bench::parse_list<size_t>(argv[1]);
+    std::vector<int> thread_counts = (argc > 2) ? bench::parse_list<int>(argv[2]) : std::vector<int>{static_cast<int>(std::thread::hardware_concurrency())};
+    if (vector_sizes.empty() || thread_counts.empty()) return usage();
+    for (int& t : thread_counts) if (t <= 0) t = 1;
+    const int max_threads = *std::max_element(thread_counts.begin(), thread_counts.end());
+
+    placement.pin_self(0); // main (однопоточные сортировки и слияние) - на CPU потока 0
+    std::cout << "Placement: " << placement.describe(max_threads) << std::endl;
+    bench::Reporter reporter("parallel_sort", cfg);
+
+    for (size_t vector_size : vector_sizes) {
+        const std::string size_text = std::to_string(vector_size);
+        const bench::Params single = {{"size", size_text}, {"threads", "1"}};
+        std::vector<int> v_orig = generate_random_vector(vector_size);
+
+        // std::qsort
+        std::vector<int> v_qsort;
+        auto qsort_samples = bench::run(cfg, [&] {
+            v_qsort = v_orig;
+            return time_sort("qsort", v_qsort, [](std::vector<int>& v) { qsort(v.data(), v.size(), sizeof(int), compare_ints_qsort); });
+        }, single);
+        double qsort_time = reporter.add("qsort", single, qsort_samples).median;
+        if (!std::is_sorted(v_qsort.begin(), v_qsort.end())) std::cerr << "qsort FAILED!" << std::endl;
+
+        // std::sort (однопоточный)
+        std::vector<int> v_stdsort;
+        auto stdsort_samples = bench::run(cfg, [&] {
+            v_stdsort = v_orig;
+            return time_sort("std::sort", v_stdsort, [](std::vector<int>& v) { std::sort(v.begin(), v.end()); });
+        }, single);
+        double stdsort_time = reporter.add("std::sort", single, stdsort_samples).median;
+
+        for (int num_threads : thread_counts) {
+            std::cout << "Vector size: " << vector_size << ", Parallel sort threads: " << num_threads << std::endl;
+            std::cout << "qsort time: " << qsort_time << " ms" << std::endl;
+            std::cout << "std::sort time: " << stdsort_time << " ms" << std::endl;
+
+            // parallel_merge_sort; копия с первым касанием в каждом повторе, вне замера
+            SortVector v_parallel(vector_size);
+            const bench::Params params = {{"size", size_text}, {"threads", std::to_string(num_threads)}};
+            auto parallel_samples = bench::run(cfg, [&] {
+                first_touch_copy(v_orig, v_parallel, num_threads);
+                return time_sort("parallel_sort", v_parallel, [num_threads](SortVector& v) { parallel_merge_sort(v, num_threads); });
+            }, params);
+            double parallel_time = reporter.add("parallel", params, parallel_samples).median;
+            std::cout << "Parallel sort time (" << num_threads << " threads): " << parallel_time << " ms" << std::endl;
+
+            // Проверка
+            if (!std::is_sorted(v_parallel.begin(), v_parallel.end())) std::cerr << "Parallel sort FAILED!" << std::endl;
+
+            // Для Python скрипта (медианы)
+            std::cout << "DATAPOINT: " << vector_size << " " << num_threads << " "
+                      << qsort_time << " " << stdsort_time << " " << parallel_time << std::endl;
+        }
+    }
+
+    perf::report(std::cout);
+    reporter.set_meta("placement", placement.describe(max_threads)); // после замеров: с учётом неудачных привязок
+    reporter.write();
     return 0;
-}
\ No newline at end of file
+}
@@ -7,6 +7,9 @@
 #include <cstdlib> // (exit, EXIT_FAILURE)
 #include <fcntl.h> // Чисто под WIN Содержит определения для управления файловыми дескрипторами
 #include <atomic>
+#include "affinity.h" // привязка потоков (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
 
 // Чисто для WIN
 // Переопределение системныхPOSIX на аналоги в Windows (_pipe, _read, _write, _close)
@@ -24,15 +27,18 @@ const size_t MESSAGE_SIZE = 4096;  // Размер одного сообщени
 const int NUM_MESSAGES = 10000; // Количество сообщений для теста.
 int pipe_fds[2]; // дискрипторы[0] read, [1] write
 std::atomic<bool> reader_ready(false); // Сигнал, что читатель готов
+const affinity::Placement placement = affinity::Placement::from_env(); // читатель - 0, писатель - 1
 
 // msg error
 void die(const char* msg) { perror(msg); exit(EXIT_FAILURE); }
 
 // Поток-чтение из pipe
 void reader_thread_func() {
+    placement.pin_self(0); // до выделения буфера (first touch)
     std::vector<char> buffer(MESSAGE_SIZE);
     reader_ready.store(true); // Сообщаем о готовности
 
+    perf::Region region("reader");
     for (int i = 0; i < NUM_MESSAGES; ++i) {
         int bytes_read = read(pipe_fds[0], buffer.data(), MESSAGE_SIZE);
     }
@@ -44,6 +50,7 @@ void reader_thread_func() {
 // длительность записи в мкс
 
 double writer_thread_func_timed() {
+    placement.pin_self(1);
 
 // переменные
     std::vector<char> message(MESSAGE_SIZE, 'X');
@@ -57,16 +64,19 @@ double writer_thread_func_timed() {
 
     start_time = std::chrono::high_resolution_clock::now(); // <-- Запускаем таймер
 
-    for (int i = 0; i < NUM_MESSAGES; ++i) {
-        int bytes_written = write(pipe_fds[1], message.data(), MESSAGE_SIZE);
-        if (bytes_written < static_cast<int>(MESSAGE_SIZE)) {
-            if (bytes_written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) perror("write to pipe in writer");
-            else std::cerr << "Writer: Partial write occurred." << std::endl;
-            // Если произошла ошибка, останавливаем таймер и выходим
-             end_time = std::chrono::high_resolution_clock::now(); // <-- Остановка по ошибке
-             goto end_loop; // Используем goto для простоты выхода из цикла и замера
+    {
+        perf::Region region("writer");
+        for (int i = 0; i < NUM_MESSAGES; ++i) {
+            int bytes_written = write(pipe_fds[1], message.data(), MESSAGE_SIZE);
+            if (bytes_written < static_cast<int>(MESSAGE_SIZE)) {
+                if (bytes_written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) perror("write to pipe in writer");
+                else std::cerr << "Writer: Partial write occurred." << std::endl;
+                // Если произошла ошибка, останавливаем таймер и выходим
+                 end_time = std::chrono::high_resolution_clock::now(); // <-- Остановка по ошибке
+                 goto end_loop; // Используем goto для простоты выхода из цикла и замера
+            }
+            total_bytes_written += bytes_written;
         }
-        total_bytes_written += bytes_written;
     }
 
     end_time = std::chrono::high_resolution_clock::now(); // <-- Останавливаем таймер
@@ -77,13 +87,15 @@ end_loop:
     return std::chrono::duration<double, std::micro>(end_time - start_time).count();
 }
 
-int main() {
+// Один прогон: новый пайп и пара потоков, результат - время цикла писателя (мкс)
+double run_pipe_once() {
     // 1. Создание пайпа (не входит в измеряемое время)
 #ifdef _WIN32
     if (pipe(pipe_fds, 0, _O_BINARY) == -1) die("_pipe creation failed");
 #else
     if (pipe(pipe_fds) == -1) die("pipe creation failed");
 #endif
+    reader_ready.store(false);
 
     // 2. Создание потоков (не входит в измеряемое время)
     std::thread reader(reader_thread_func);
@@ -103,8 +115,18 @@ int main() {
 
     // 4. Закрытие оставшегося дескриптора пайпа (если читатель не закрыл)
     close(pipe_fds[0]);
+    return writer_duration_us;
+}
+
+int main(int argc, char* argv[]) {
+    bench::Config cfg = bench::parse_args(argc, argv); // --warmup/--reps/--outliers/--format/--out
+    bench::Reporter reporter("pipe_benchmark", cfg);
+
+    const bench::Params params = {{"messages", std::to_string(NUM_MESSAGES)}, {"size", std::to_string(MESSAGE_SIZE)}};
+    auto samples = bench::run(cfg, run_pipe_once, params);
+    double writer_duration_us = reporter.add("pipe/writer_loop", params, samples, "us").median;
 
-    // 5. Вывод результатов на основе времени работы писателя
+    // 5. Вывод результатов на основе времени работы писателя (медиана повторов)
     double total_data_mb = static_cast<double>(NUM_MESSAGES * MESSAGE_SIZE) / (1024.0 * 1024.0);
     double duration_s = writer_duration_us / 1e6;
     double throughput_mbps = (duration_s > 0) ? (total_data_mb / duration_s) : 0;
@@ -112,9 +134,13 @@ int main() {
 
     std::cout << "Pipe-like Benchmark (Threads - Writer Loop Time):" << std::endl;
     std::cout << "  Messages: " << NUM_MESSAGES << ", Size: " << MESSAGE_SIZE << " B" << std::endl;
+    std::cout << "  Placement: " << placement.describe(2) << std::endl;
     std::cout << "  Writer loop time: " << writer_duration_us << " us (" << duration_s << " s)" << std::endl;
     std::cout << "  Approx Throughput (based on writer time): " << throughput_mbps << " MB/s" << std::endl;
     std::cout << "  Avg Latency/msg (based on writer time): " << latency_us_msg << " us" << std::endl;
+    perf::report(std::cout);
+    reporter.set_meta("placement", placement.describe(2)); // после замеров: с учётом неудачных привязок
+    reporter.write();
 
     return 0;
 }
\ No newline at end of file
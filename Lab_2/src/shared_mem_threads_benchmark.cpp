@@ -1,4 +1,3 @@
-
 #include <iostream>
 #include <vector>
 #include <thread> // поток
@@ -7,110 +6,190 @@
 #include <chrono>
 #include <numeric>
 #include <atomic> // Для барьера
-// чтобы исключить время создания потоков
-
-// Барьер, чтобы синхронизировать потоки
-class Barrier {
-    std::mutex mtx;
-    std::condition_variable cv;
-    size_t count;
-    const size_t initial_count;
-    int generation = 0;
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+#include "spsc_ring.h" // lock-free SPSC кольцо
+#include "barriers.h" // MutexBarrier
+#include "affinity.h" // привязка потоков (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
 
-public:
-// init барьер
-    explicit Barrier(size_t initial_count_) : count(initial_count_), initial_count(initial_count_) {}
-
-    void wait() {
-        std::unique_lock<std::mutex> lock(mtx);
-        int current_generation = generation;
-        if (--count == 0) {
-            generation++; // Сменить поколение
-            count = initial_count; // Сбросить счетчик для nest step
-            cv.notify_all();
-        } else {
-            cv.wait(lock, [&] { return generation != current_generation; });
-        }
-    }
-};
-// конц барьера
 // ПАРАМЕТРЫ
 
-const size_t DATA_SIZE = 4096; // Размер одного блока.
-const int NUM_ROUND_TRIPS = 10000; // Количество полных циклов
-
-std::vector<char> shared_buffer(DATA_SIZE); // разделяемая память
-std::mutex mtx_comm; // Мьютекс для коммуникации
-std::condition_variable cv_comm; // CV для коммуникации
-// флаги
-bool ping_turn = true;
-bool data_ready = false;
+const std::vector<size_t> DEFAULT_SIZES = {64, 1024, 4096, 65536}; // Размеры сообщений (байт)
+const int NUM_ROUND_TRIPS = 10000; // Количество полных циклов (задержка)
+const int NUM_STREAM_MESSAGES = 100000; // Сообщений в потоковом тесте (пропускная способность)
+const size_t STREAM_BYTES_LIMIT = size_t(1) << 30; // Не гоняем больше 1 ГБ на размер
+const uint32_t RING_SLOTS = 16; // Слотов в кольце
+const affinity::Placement placement = affinity::Placement::from_env(); // ping/писатель - 0, pong/читатель - 1
+
+// Исходный канал: один общий буфер под мьютексом + CV, копирование присваиванием vector
+class LockedChannel {
+    std::vector<char> shared_buffer; // разделяемая память
+    std::mutex mtx_comm; // Мьютекс для коммуникации
+    std::condition_variable cv_comm; // CV для коммуникации
+    // флаги
+    bool ping_turn = true;
+    bool data_ready = false;
 
-Barrier setup_barrier(3); // Барьер для 3 потоков: main, ping, pong
-
-// Поток "Ping" отправка в общий буфер 
-void ping_thread_func() {
-    std::vector<char> local_data(DATA_SIZE, 'P');
-    setup_barrier.wait(); // Синхронизация перед началом работы
+public:
+    static constexpr const char* name = "mutex-condvar";
+    explicit LockedChannel(size_t) {}
 
-// Выполняем заданное количество циклов отправки.
-    for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+    void send(const std::vector<char>& local_data) {
         std::unique_lock<std::mutex> lock(mtx_comm);
-        cv_comm.wait(lock, [] { return ping_turn; });
-        if (DATA_SIZE > 0) shared_buffer = local_data;
+        cv_comm.wait(lock, [this] { return ping_turn; });
+        shared_buffer = local_data;
         ping_turn = false; data_ready = true;
         lock.unlock();
         cv_comm.notify_one();
     }
-}
-
-// Поток "Pong"
-void pong_thread_func() {
-    std::vector<char> local_recv_buffer(DATA_SIZE);
-    setup_barrier.wait(); // Синхронизация перед началом работы
 
-// Выполняем заданное количество циклов приема.
-    for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+    void recv(std::vector<char>& local_recv_buffer) {
         std::unique_lock<std::mutex> lock(mtx_comm);
-        cv_comm.wait(lock, [] { return !ping_turn && data_ready; });
-        if (DATA_SIZE > 0) local_recv_buffer = shared_buffer;
+        cv_comm.wait(lock, [this] { return !ping_turn && data_ready; });
+        local_recv_buffer = shared_buffer;
         ping_turn = true; data_ready = false;
         lock.unlock();
         cv_comm.notify_one();
     }
-}
+};
 
-int main() {
-    // 1. Создание потоков (не входит в итог время)
-    std::thread t_ping(ping_thread_func);
-    std::thread t_pong(pong_thread_func);
+// Канал поверх SPSC кольца с выбранной политикой ожидания
+template <class Wait>
+class RingChannel {
+    struct Deleter { void operator()(void* p) const { ::operator delete(p, std::align_val_t(CACHE_LINE)); } };
+    std::unique_ptr<void, Deleter> memory;
+    SpscRing<Wait>* ring;
 
-    // 2. Синхронизация:  пока все потоки будут готовы
-    setup_barrier.wait();
+public:
+    static constexpr const char* name = Wait::name;
+    explicit RingChannel(size_t message_size)
+        : memory(::operator new(SpscRing<Wait>::footprint(static_cast<uint32_t>(message_size), RING_SLOTS), std::align_val_t(CACHE_LINE))),
+          ring(SpscRing<Wait>::create(memory.get(), static_cast<uint32_t>(message_size), RING_SLOTS)) {}
 
-    // 3. Запуск таймера и выполнение "пинг-понга"
-    // Старт таймера
-    auto start_time = std::chrono::high_resolution_clock::now();
+    void send(const std::vector<char>& local_data) { ring->push(local_data.data(), static_cast<uint32_t>(local_data.size())); }
+    void recv(std::vector<char>& local_recv_buffer) { ring->pop(local_recv_buffer.data()); }
+};
+
+struct Result {
+    double latency_us_round_trip; // ping -> pong -> ping
+    double throughput_mbps;       // потоковая передача в одну сторону
+};
 
-    // 4. Ожидание завершения потоков (не входит в итог время)
+// Пинг-понг: ping шлёт блок в pong, pong возвращает блок того же размера
+template <class Channel>
+double measure_round_trip_us(size_t data_size) {
+    Channel to_pong(data_size), to_ping(data_size);
+    MutexBarrier setup_barrier(3); // Барьер для 3 потоков: main, ping, pong
+
+    std::thread t_ping([&] {
+        placement.pin_self(0); // до выделения локальных буферов (first touch)
+        std::vector<char> local_data(data_size, 'P'), local_recv_buffer(data_size);
+        setup_barrier.wait(); // Синхронизация перед началом работы
+        perf::Region region(std::string(Channel::name) + "/rtt/" + std::to_string(data_size));
+        for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            to_pong.send(local_data);
+            to_ping.recv(local_recv_buffer);
+        }
+    });
+    std::thread t_pong([&] {
+        placement.pin_self(1);
+        std::vector<char> local_recv_buffer(data_size);
+        setup_barrier.wait();
+        for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            to_pong.recv(local_recv_buffer);
+            to_ping.send(local_recv_buffer);
+        }
+    });
+
+    setup_barrier.wait();
+    auto start_time = std::chrono::high_resolution_clock::now(); // Старт таймера
     t_ping.join();
     t_pong.join();
-
     auto end_time = std::chrono::high_resolution_clock::now(); // <-- Таймер СТОП
-    auto duration_us = std::chrono::duration<double, std::micro>(end_time - start_time).count();
+    return std::chrono::duration<double, std::micro>(end_time - start_time).count() / NUM_ROUND_TRIPS;
+}
+
+// Поток сообщений в одну сторону (пропускная способность), МБ/с
+template <class Channel>
+double measure_throughput_mbps(size_t data_size) {
+    const int messages = static_cast<int>(std::min<size_t>(NUM_STREAM_MESSAGES, STREAM_BYTES_LIMIT / data_size));
+    Channel channel(data_size);
+    MutexBarrier setup_barrier(3);
+
+    std::thread producer([&] {
+        placement.pin_self(0);
+        std::vector<char> local_data(data_size, 'P');
+        setup_barrier.wait();
+        perf::Region region(std::string(Channel::name) + "/stream/" + std::to_string(data_size));
+        for (int i = 0; i < messages; ++i) channel.send(local_data);
+    });
+    std::thread consumer([&] {
+        placement.pin_self(1);
+        std::vector<char> local_recv_buffer(data_size);
+        setup_barrier.wait();
+        for (int i = 0; i < messages; ++i) channel.recv(local_recv_buffer);
+    });
+
+    setup_barrier.wait();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    producer.join();
+    consumer.join();
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double duration_s = std::chrono::duration<double>(end_time - start_time).count();
+    double total_data_mb = static_cast<double>(messages) * data_size / (1024.0 * 1024.0);
+    return (duration_s > 0) ? total_data_mb / duration_s : 0;
+}
 
-    // 5. Вывод результатов
-    double latency_us_round_trip = (NUM_ROUND_TRIPS > 0) ? (duration_us / NUM_ROUND_TRIPS) : 0;
-    double total_data_mb = static_cast<double>(NUM_ROUND_TRIPS * 2 * DATA_SIZE) / (1024.0 * 1024.0);
-    double throughput_mbps = (duration_us > 0 && DATA_SIZE > 0) ? (total_data_mb / (duration_us / 1e6)) : 0;
+template <class Channel>
+void run_channel(size_t data_size, const bench::Config& cfg, bench::Reporter& reporter) {
+    const bench::Params params = {{"channel", Channel::name}, {"size", std::to_string(data_size)}};
+    Result r;
+    r.latency_us_round_trip = reporter.add("round_trip", params, bench::run(cfg, [data_size] { return measure_round_trip_us<Channel>(data_size); }, params), "us").median;
+    r.throughput_mbps = reporter.add("throughput", params, bench::run(cfg, [data_size] { return measure_throughput_mbps<Channel>(data_size); }, params), "MB/s").median;
+    std::cout << "  " << Channel::name << ": size " << data_size << " B, latency/round_trip "
+              << r.latency_us_round_trip << " us, throughput " << r.throughput_mbps << " MB/s" << std::endl;
+    // Для Python скрипта
+    std::cout << "DATAPOINT_CHANNEL: " << Channel::name << " " << data_size << " "
+              << r.latency_us_round_trip << " " << r.throughput_mbps << std::endl;
+}
+
+// Запуск: shared_mem_benchmark [size1 size2 ...] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]
+int main(int argc, char* argv[]) {
+    bench::Config cfg = bench::parse_args(argc, argv);
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        std::vector<size_t> values = bench::parse_list<size_t>(argv[i]);
+        if (values.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [size1 size2 ...] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]" << std::endl;
+            return 1;
+        }
+        sizes.insert(sizes.end(), values.begin(), values.end());
+    }
+    if (sizes.empty()) sizes = DEFAULT_SIZES;
+
+    // Чистый спин на одном ядре отдаёт процессор только по кванту планировщика - бессмысленно
+    const bool can_busy_spin = std::thread::hardware_concurrency() >= 2;
 
     std::cout << "Shared Memory (Threads) Benchmark (Communication Time):" << std::endl;
-    std::cout << "  Round trips: " << NUM_ROUND_TRIPS << ", Data size/transfer: " << DATA_SIZE << " B" << std::endl;
-    std::cout << "  Total communication time: " << duration_us << " us" << std::endl;
-    std::cout << "  Avg latency/round_trip: " << latency_us_round_trip << " us" << std::endl;
-    if (DATA_SIZE > 0) {
-         std::cout << "  Approx Throughput: " << throughput_mbps << " MB/s" << std::endl;
+    std::cout << "  Round trips: " << NUM_ROUND_TRIPS << ", stream messages: " << NUM_STREAM_MESSAGES
+              << ", ring slots: " << RING_SLOTS << std::endl;
+    std::cout << "  Placement: " << placement.describe(2) << std::endl;
+    bench::Reporter reporter("shared_mem_benchmark", cfg);
+    for (size_t data_size : sizes) {
+        if (data_size == 0) continue;
+        run_channel<LockedChannel>(data_size, cfg, reporter);
+        if (can_busy_spin) run_channel<RingChannel<wait_policy::BusySpin>>(data_size, cfg, reporter);
+        else std::cout << "  " << wait_policy::BusySpin::name << ": skipped (single CPU)" << std::endl;
+        run_channel<RingChannel<wait_policy::SpinYield>>(data_size, cfg, reporter);
+        run_channel<RingChannel<wait_policy::SpinFutex>>(data_size, cfg, reporter);
     }
+    perf::report(std::cout);
+    reporter.set_meta("placement", placement.describe(2)); // после замеров: с учётом неудачных привязок
+    reporter.write();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,341 @@
+// Межпроцессная передача: pipe против кольца SPSC в сегменте shm_open/mmap.
+// Родитель и потомок (fork) обмениваются сообщениями одинаковых размеров через:
+//   pipe       - два канала pipe (туда и обратно), копирование через ядро;
+//   shm-copy   - кольцо в разделяемой памяти, сообщение собирается локально и копируется в слот;
+//   shm-inplace- то же кольцо, сообщение собирается прямо в слоте (zero-copy).
+// Ожидание в кольце - спин, затем futex на слове в разделяемой памяти (без FUTEX_PRIVATE) с таймаутом:
+// между снами проверяется, что процесс-партнёр жив (иначе смерть потомка повесила бы родителя).
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>  // perror
+#include <cstdlib> // exit, EXIT_FAILURE
+#include <algorithm>
+#include <fcntl.h>     // O_* для shm_open
+#include <sys/mman.h>  // shm_open, mmap
+#include <sys/wait.h>  // waitpid
+#include <unistd.h>    // fork, pipe, ftruncate
+#include "spsc_ring.h"
+#include "affinity.h" // привязка процессов (LAB_AFFINITY)
+#include "perf_counters.h" // аппаратные счётчики по областям
+#include "bench_harness.h" // повторы, статистика, JSON/CSV
+
+const std::vector<size_t> DEFAULT_SIZES = {64, 1024, 4096, 65536}; // Размеры сообщений (байт)
+const int NUM_ROUND_TRIPS = 10000; // Пинг-понгов для задержки
+const int NUM_STREAM_MESSAGES = 100000; // Сообщений в потоковом тесте
+const size_t STREAM_BYTES_LIMIT = size_t(1) << 30; // Не гоняем больше 1 ГБ на размер
+const uint32_t RING_SLOTS = 16;
+const uint32_t ACK_BYTES = 1; // Служебные сообщения (готовность, подтверждение)
+
+// Кто у этого процесса партнёр по кольцу: родитель следит за потомком, потомок - за родителем
+pid_t watched_child = 0; // у родителя - pid текущего потомка, у потомка - 0
+pid_t parent_pid = 0;
+
+// Если партнёр умер, futex никто не разбудит: ждём с таймаутом и проверяем, жив ли он
+struct PeerWatch {
+    static constexpr timespec POLL = {0, 100 * 1000 * 1000}; // 100 мс
+    static void check() {
+        if (watched_child > 0) {
+            int status = 0;
+            if (waitpid(watched_child, &status, WNOHANG) == watched_child) {
+                std::cerr << "Child process exited while the parent was waiting on the ring" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (getppid() != parent_pid) {
+            _exit(EXIT_FAILURE); // родитель умер, результат никому не нужен
+        }
+    }
+};
+
+using Ring = SpscRing<wait_policy::SpinFutexWatched<PeerWatch>>;
+const affinity::Placement placement = affinity::Placement::from_env(); // родитель - 0, потомок - 1
+
+// msg error
+void die(const char* msg) { perror(msg); exit(EXIT_FAILURE); }
+
+volatile unsigned checksum_sink = 0; // чтобы компилятор не выбросил чтение сообщения
+
+// "Сборка" сообщения и его "потребление" одинаковы для всех транспортов
+void build_message(char* data, uint32_t bytes, char pattern) { std::memset(data, pattern, bytes); }
+void consume_message(const char* data, uint32_t bytes) {
+    unsigned sum = 0;
+    for (uint32_t i = 0; i < bytes; i += CACHE_LINE) sum += static_cast<unsigned char>(data[i]);
+    checksum_sink = checksum_sink + sum;
+}
+
+// Конечная точка канала: begin_* отдаёт буфер для сборки/чтения, end_* завершает передачу.
+// --- pipe ---
+class PipeEndpoint {
+    int read_fd, write_fd;
+    std::vector<char> send_buffer, recv_buffer;
+
+public:
+    PipeEndpoint(int read_fd_, int write_fd_, size_t max_bytes)
+        : read_fd(read_fd_), write_fd(write_fd_), send_buffer(max_bytes), recv_buffer(max_bytes) {}
+
+    char* begin_send(uint32_t) { return send_buffer.data(); }
+    void end_send(uint32_t bytes) {
+        for (uint32_t done = 0; done < bytes;) { // запись > PIPE_BUF может быть частичной
+            ssize_t n = write(write_fd, send_buffer.data() + done, bytes - done);
+            if (n < 0) die("write to pipe");
+            done += static_cast<uint32_t>(n);
+        }
+    }
+    const char* begin_recv(uint32_t bytes) {
+        for (uint32_t done = 0; done < bytes;) {
+            ssize_t n = read(read_fd, recv_buffer.data() + done, bytes - done);
+            if (n <= 0) die("read from pipe");
+            done += static_cast<uint32_t>(n);
+        }
+        return recv_buffer.data();
+    }
+    void end_recv() {}
+};
+
+// --- кольцо в разделяемой памяти, копирование в слот и из слота ---
+class ShmCopyEndpoint {
+    Ring* out; Ring* in;
+    std::vector<char> send_buffer, recv_buffer;
+
+public:
+    ShmCopyEndpoint(Ring* in_, Ring* out_, size_t max_bytes)
+        : out(out_), in(in_), send_buffer(max_bytes), recv_buffer(max_bytes) {}
+
+    char* begin_send(uint32_t) { return send_buffer.data(); }
+    void end_send(uint32_t bytes) { out->push(send_buffer.data(), bytes); }
+    const char* begin_recv(uint32_t) { in->pop(recv_buffer.data()); return recv_buffer.data(); }
+    void end_recv() {}
+};
+
+// --- кольцо в разделяемой памяти, сообщение живёт прямо в слоте ---
+class ShmInPlaceEndpoint {
+    Ring* out; Ring* in;
+
+public:
+    ShmInPlaceEndpoint(Ring* in_, Ring* out_, size_t) : out(out_), in(in_) {}
+
+    char* begin_send(uint32_t) { return out->claim(); }
+    void end_send(uint32_t bytes) { out->publish(bytes); }
+    const char* begin_recv(uint32_t) { uint32_t bytes = 0; return in->peek(bytes); }
+    void end_recv() { in->release(); }
+};
+
+template <class Endpoint>
+void send_message(Endpoint& e, uint32_t bytes, char pattern) {
+    build_message(e.begin_send(bytes), bytes, pattern);
+    e.end_send(bytes);
+}
+
+template <class Endpoint>
+void recv_message(Endpoint& e, uint32_t bytes) {
+    consume_message(e.begin_recv(bytes), bytes);
+    e.end_recv();
+}
+
+// Области потомка записываются в его копию реестра: перед выходом он отдаёт свои PERF-строки
+// в отдельный канал, родитель собирает их и печатает после своих
+std::string child_perf_lines;
+
+void send_child_report(int fd) {
+    std::ostringstream out;
+    perf::report_samples(out, "child");
+    const std::string text = out.str();
+    for (size_t done = 0; done < text.size();) {
+        ssize_t n = write(fd, text.data() + done, text.size() - done);
+        if (n <= 0) break; // родитель не дочитал - без счётчиков потомка
+        done += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+
+void collect_child_report(int fd) {
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) child_perf_lines.append(buffer, static_cast<size_t>(n));
+    close(fd);
+}
+
+int stream_messages(size_t bytes) { return static_cast<int>(std::min<size_t>(NUM_STREAM_MESSAGES, STREAM_BYTES_LIMIT / bytes)); }
+
+// Потомок: готовность -> эхо для пинг-понга -> приём потока -> подтверждение
+template <class Endpoint>
+void child_side(Endpoint& e, uint32_t bytes) {
+    send_message(e, ACK_BYTES, 'R');
+    {
+        perf::Region region("echo");
+        for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            recv_message(e, bytes);
+            send_message(e, bytes, 'C');
+        }
+    }
+    {
+        perf::Region region("stream_recv");
+        for (int i = 0, n = stream_messages(bytes); i < n; ++i) recv_message(e, bytes);
+    }
+    send_message(e, ACK_BYTES, 'A');
+}
+
+struct Result {
+    double latency_us; // в одну сторону (половина пинг-понга)
+    double throughput_gbps;
+};
+
+// Родитель: замеры
+template <class Endpoint>
+Result parent_side(Endpoint& e, uint32_t bytes) {
+    recv_message(e, ACK_BYTES); // потомок готов
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    {
+        perf::Region region("round_trip");
+        for (int i = 0; i < NUM_ROUND_TRIPS; ++i) {
+            send_message(e, bytes, 'P');
+            recv_message(e, bytes);
+        }
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double latency_us = std::chrono::duration<double, std::micro>(end_time - start_time).count() / (2.0 * NUM_ROUND_TRIPS);
+
+    const int messages = stream_messages(bytes);
+    start_time = std::chrono::high_resolution_clock::now();
+    {
+        perf::Region region("stream");
+        for (int i = 0; i < messages; ++i) send_message(e, bytes, 'P');
+        recv_message(e, ACK_BYTES); // потомок всё прочитал
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    double duration_s = std::chrono::duration<double>(end_time - start_time).count();
+    double total_gb = static_cast<double>(messages) * bytes / (1024.0 * 1024.0 * 1024.0);
+    return {latency_us, (duration_s > 0) ? total_gb / duration_s : 0};
+}
+
+void wait_child(pid_t pid) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) die("waitpid");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) { std::cerr << "Child process failed" << std::endl; exit(EXIT_FAILURE); }
+}
+
+Result run_pipe(uint32_t bytes) {
+    int to_child[2], to_parent[2], perf_pipe[2];
+    if (pipe(to_child) == -1 || pipe(to_parent) == -1 || pipe(perf_pipe) == -1) die("pipe creation failed");
+    pid_t pid = fork();
+    if (pid < 0) die("fork");
+    if (pid == 0) {
+        perf::after_fork();
+        placement.pin_self(1);
+        close(to_child[1]); close(to_parent[0]); close(perf_pipe[0]);
+        PipeEndpoint e(to_child[0], to_parent[1], bytes);
+        child_side(e, bytes);
+        send_child_report(perf_pipe[1]);
+        _exit(0);
+    }
+    close(to_child[0]); close(to_parent[1]); close(perf_pipe[1]);
+    PipeEndpoint e(to_parent[0], to_child[1], bytes);
+    Result r = parent_side(e, bytes);
+    close(to_parent[0]); close(to_child[1]);
+    collect_child_report(perf_pipe[0]);
+    wait_child(pid);
+    return r;
+}
+
+template <class Endpoint>
+Result run_shm(uint32_t bytes) {
+    // Сегмент: [кольцо родитель->потомок][кольцо потомок->родитель]
+    const size_t ring_bytes = Ring::footprint(bytes, RING_SLOTS);
+    const size_t segment_bytes = 2 * ring_bytes;
+    const std::string name = "/parprog_shm_ipc_" + std::to_string(getpid());
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) die("shm_open");
+    if (ftruncate(fd, static_cast<off_t>(segment_bytes)) != 0) die("ftruncate");
+    void* base = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) die("mmap");
+    close(fd);
+    shm_unlink(name.c_str()); // отображение остаётся, имя в /dev/shm не утекает при аварии
+
+    Ring* to_child = Ring::create(base, bytes, RING_SLOTS);
+    Ring* to_parent = Ring::create(static_cast<char*>(base) + ring_bytes, bytes, RING_SLOTS);
+
+    int perf_pipe[2];
+    if (pipe(perf_pipe) == -1) die("pipe creation failed");
+    parent_pid = getpid();
+    pid_t pid = fork();
+    if (pid < 0) die("fork");
+    if (pid == 0) {
+        perf::after_fork();
+        watched_child = 0;
+        placement.pin_self(1);
+        close(perf_pipe[0]);
+        Endpoint e(to_child, to_parent, bytes);
+        child_side(e, bytes);
+        send_child_report(perf_pipe[1]);
+        _exit(0);
+    }
+    close(perf_pipe[1]);
+    watched_child = pid;
+    Endpoint e(to_parent, to_child, bytes);
+    Result r = parent_side(e, bytes);
+    collect_child_report(perf_pipe[0]);
+    wait_child(pid);
+    watched_child = 0;
+    munmap(base, segment_bytes);
+    return r;
+}
+
+void print_result(const char* transport, uint32_t bytes, const Result& r) {
+    std::cout << "  " << transport << ": latency " << r.latency_us << " us, throughput " << r.throughput_gbps << " GB/s" << std::endl;
+    // Для Python скрипта
+    std::cout << "DATAPOINT_IPC: " << transport << " " << bytes << " " << r.latency_us << " " << r.throughput_gbps << std::endl;
+}
+
+// Повторы одного транспорта: в статистику идут задержка и пропускная способность, печатаются медианы
+template <class RunFn>
+void run_transport(const char* transport, uint32_t bytes, RunFn run_once, const bench::Config& cfg, bench::Reporter& reporter) {
+    const bench::Params params = {{"transport", transport}, {"size", std::to_string(bytes)}};
+    bench::Series series = bench::run_multi(cfg, [&] {
+        Result r = run_once(bytes);
+        return bench::Metrics{{"latency", r.latency_us}, {"throughput", r.throughput_gbps}};
+    }, params);
+    Result r;
+    r.latency_us = reporter.add("latency", params, series["latency"], "us").median;
+    r.throughput_gbps = reporter.add("throughput", params, series["throughput"], "GB/s").median;
+    print_result(transport, bytes, r);
+}
+
+// Запуск: shm_ipc_benchmark [size1 size2 ...] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]
+int main(int argc, char* argv[]) {
+    bench::Config cfg = bench::parse_args(argc, argv);
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        std::vector<size_t> values = bench::parse_list<size_t>(argv[i]);
+        if (values.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [size1 size2 ...] [--warmup N] [--reps N] [--outliers K] [--format json|csv] [--out FILE]" << std::endl;
+            return 1;
+        }
+        sizes.insert(sizes.end(), values.begin(), values.end());
+    }
+    if (sizes.empty()) sizes = DEFAULT_SIZES;
+
+    placement.pin_self(0);
+    std::cout << "IPC Benchmark (Processes): pipe vs shm_open/mmap SPSC ring (" << wait_policy::SpinFutex::name << ")" << std::endl;
+    std::cout << "  Round trips: " << NUM_ROUND_TRIPS << ", stream messages: " << NUM_STREAM_MESSAGES
+              << ", ring slots: " << RING_SLOTS << ", latency is one-way (round trip / 2)" << std::endl;
+    std::cout << "  Placement: " << placement.describe(2) << std::endl;
+    bench::Reporter reporter("shm_ipc_benchmark", cfg);
+    for (size_t size : sizes) {
+        if (size < ACK_BYTES) continue;
+        const uint32_t bytes = static_cast<uint32_t>(size);
+        std::cout << "Size: " << bytes << " B" << std::endl;
+        run_transport("pipe", bytes, run_pipe, cfg, reporter);
+        run_transport("shm-copy", bytes, run_shm<ShmCopyEndpoint>, cfg, reporter);
+        run_transport("shm-inplace", bytes, run_shm<ShmInPlaceEndpoint>, cfg, reporter);
+    }
+    perf::report(std::cout);
+    std::cout << child_perf_lines << std::flush;
+    reporter.set_meta("placement", placement.describe(2)); // после замеров: с учётом неудачных привязок
+    reporter.write();
+    return 0;
+}
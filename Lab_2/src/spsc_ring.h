@@ -0,0 +1,121 @@
+#pragma once
+// Lock-free кольцевой буфер "один писатель - один читатель" (SPSC) с фиксированными слотами.
+// Объект не содержит указателей: заголовок и слоты лежат одним блоком памяти,
+// поэтому кольцо можно разместить и в обычной куче, и в сегменте shm_open/mmap.
+//
+// Раскладка: [конфиг][head][tail][кэш писателя][кэш читателя][спящие]...[слоты]
+// каждое поле на своей кэш-линии, чтобы писатель и читатель не делили линии (false sharing).
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "wait_policy.h"
+
+inline size_t round_up_cache_line(size_t bytes) { return (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE; }
+
+template <class Wait>
+class SpscRing {
+    // Конфиг (только чтение после создания)
+    alignas(CACHE_LINE) uint32_t slot_bytes;  // макс. размер сообщения
+    uint32_t slot_stride;                     // шаг слота: длина (1 линия) + полезная нагрузка
+    uint32_t mask;                            // slot_count - 1 (slot_count - степень двойки)
+
+    // Индексы растут монотонно (переполнение uint32_t корректно при степени двойки)
+    alignas(CACHE_LINE) std::atomic<uint32_t> head{0};  // пишет писатель
+    alignas(CACHE_LINE) std::atomic<uint32_t> tail{0};  // пишет читатель
+    alignas(CACHE_LINE) uint32_t cached_tail = 0;       // локальная копия tail у писателя
+    alignas(CACHE_LINE) uint32_t cached_head = 0;       // локальная копия head у читателя
+    alignas(CACHE_LINE) std::atomic<uint32_t> head_sleepers{0}; // читатели, спящие на head
+    alignas(CACHE_LINE) std::atomic<uint32_t> tail_sleepers{0}; // писатели, спящие на tail
+
+    SpscRing(uint32_t slot_bytes_, uint32_t slot_count)
+        : slot_bytes(slot_bytes_),
+          slot_stride(static_cast<uint32_t>(CACHE_LINE + round_up_cache_line(slot_bytes_))),
+          mask(slot_count - 1) {}
+
+    // Сообщение больше слота перезаписало бы следующий слот и его заголовок - ошибка вызывающего
+    void check_size(uint32_t bytes) const {
+        if (bytes <= slot_bytes) return;
+        std::fprintf(stderr, "SpscRing: message of %u bytes exceeds slot size %u\n", bytes, slot_bytes);
+        std::abort();
+    }
+
+    char* slot(uint32_t index) {
+        return reinterpret_cast<char*>(this) + round_up_cache_line(sizeof(SpscRing)) + size_t(index & mask) * slot_stride;
+    }
+
+public:
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Сколько байт нужно под кольцо (slot_count округляется до степени двойки)
+    static size_t footprint(uint32_t slot_bytes_, uint32_t slot_count) {
+        uint32_t n = 1; while (n < slot_count) n <<= 1;
+        return round_up_cache_line(sizeof(SpscRing)) + size_t(n) * (CACHE_LINE + round_up_cache_line(slot_bytes_));
+    }
+
+    // Создание в заранее выделенной памяти (выравнивание не хуже CACHE_LINE, размер footprint())
+    static SpscRing* create(void* memory, uint32_t slot_bytes_, uint32_t slot_count) {
+        uint32_t n = 1; while (n < slot_count) n <<= 1;
+        return new (memory) SpscRing(slot_bytes_, n);
+    }
+
+    uint32_t capacity() const { return mask + 1; }
+    uint32_t max_message() const { return slot_bytes; }
+
+    // --- Писатель ---
+    // Резервирует следующий слот (ждёт, если кольцо полно) и возвращает указатель на его данные.
+    // Сообщение (не больше max_message() байт) можно собирать прямо в слоте (zero-copy), затем вызвать publish().
+    char* claim() {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        while (h - cached_tail > mask) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h - cached_tail > mask) Wait::wait(tail, cached_tail, tail_sleepers);
+        }
+        return slot(h) + CACHE_LINE;
+    }
+
+    void publish(uint32_t bytes) {
+        check_size(bytes);
+        uint32_t h = head.load(std::memory_order_relaxed);
+        *reinterpret_cast<uint32_t*>(slot(h)) = bytes;
+        head.store(h + 1, std::memory_order_release);
+        Wait::wake_one(head, head_sleepers);
+    }
+
+    void push(const void* data, uint32_t bytes) {
+        check_size(bytes);
+        std::memcpy(claim(), data, bytes);
+        publish(bytes);
+    }
+
+    // --- Читатель ---
+    // Ждёт сообщение и возвращает указатель на данные в слоте (без копирования), длина в bytes.
+    // Слот остаётся занятым до release().
+    const char* peek(uint32_t& bytes) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        while (t == cached_head) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t == cached_head) Wait::wait(head, cached_head, head_sleepers);
+        }
+        const char* s = slot(t);
+        bytes = *reinterpret_cast<const uint32_t*>(s);
+        return s + CACHE_LINE;
+    }
+
+    void release() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        Wait::wake_one(tail, tail_sleepers);
+    }
+
+    uint32_t pop(void* out) {
+        uint32_t bytes = 0;
+        const char* data = peek(bytes);
+        std::memcpy(out, data, bytes);
+        release();
+        return bytes;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+// Политики ожидания для lock-free примитивов (SPSC кольцо, барьеры).
+// Все политики без состояния: ждём, пока 32-битное слово не станет != seen.
+// Счётчик "спящих" хранится рядом со словом у владельца (в т.ч. в разделяемой памяти),
+// чтобы будящая сторона делала системный вызов только при реальных ожидающих.
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include <cstddef>
+#include <ctime> // timespec
+#include <thread>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <immintrin.h>
+#endif
+
+// Размер кэш-линии: выравнивание общих слов в кольце и барьерах против false sharing
+const size_t CACHE_LINE = 64;
+
+namespace wait_policy {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex требует 32-битное слово");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "нужен lock-free atomic (в т.ч. между процессами)");
+
+// Итераций активного ожидания перед yield/futex.
+// На одном ядре спин бесполезен: партнёр не может продвинуться, пока мы не отдадим процессор.
+inline int spin_limit() {
+    static const int limit = std::thread::hardware_concurrency() > 1 ? 1000 : 0;
+    return limit;
+}
+
+// Подсказка процессору внутри спин-цикла
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// FUTEX_WAIT без _PRIVATE: слово может лежать в памяти, разделяемой между процессами (shm_open/mmap).
+// timeout - относительный; nullptr - ждать без ограничения
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t seen, const timespec* timeout = nullptr) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, seen, timeout, nullptr, 0);
+#else
+    (void)word; (void)seen; (void)timeout;
+    std::this_thread::yield();
+#endif
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, int count) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+    (void)word; (void)count;
+#endif
+}
+
+// Чистый спин: минимальная задержка, но занимает ядро целиком
+struct BusySpin {
+    static constexpr const char* name = "busy-spin";
+    static void wait(const std::atomic<uint32_t>& word, uint32_t seen, std::atomic<uint32_t>&) {
+        while (word.load(std::memory_order_acquire) == seen) cpu_relax();
+    }
+    static void wake_one(std::atomic<uint32_t>&, std::atomic<uint32_t>&) {}
+    static void wake_all(std::atomic<uint32_t>&, std::atomic<uint32_t>&) {}
+};
+
+// Спин, затем уступаем процессор планировщику
+struct SpinYield {
+    static constexpr const char* name = "spin-yield";
+    static void wait(const std::atomic<uint32_t>& word, uint32_t seen, std::atomic<uint32_t>&) {
+        for (int i = 0, n = spin_limit(); i < n; ++i) {
+            if (word.load(std::memory_order_acquire) != seen) return;
+            cpu_relax();
+        }
+        while (word.load(std::memory_order_acquire) == seen) std::this_thread::yield();
+    }
+    static void wake_one(std::atomic<uint32_t>&, std::atomic<uint32_t>&) {}
+    static void wake_all(std::atomic<uint32_t>&, std::atomic<uint32_t>&) {}
+};
+
+// Спин, затем засыпаем на futex.
+// Протокол (Dekker): ожидающий: ++sleepers, fence, перечитать слово -> futex_wait;
+// будящий: запись слова, fence, sleepers != 0 -> futex_wake. Хотя бы одна сторона увидит другую.
+struct SpinFutex {
+    static constexpr const char* name = "spin-futex";
+    static void wait(std::atomic<uint32_t>& word, uint32_t seen, std::atomic<uint32_t>& sleepers) {
+        for (int i = 0, n = spin_limit(); i < n; ++i) {
+            if (word.load(std::memory_order_acquire) != seen) return;
+            cpu_relax();
+        }
+        while (word.load(std::memory_order_acquire) == seen) {
+            sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (word.load(std::memory_order_relaxed) == seen) futex_wait(word, seen);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    static void wake_one(std::atomic<uint32_t>& word, std::atomic<uint32_t>& sleepers) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0) futex_wake(word, 1);
+    }
+    static void wake_all(std::atomic<uint32_t>& word, std::atomic<uint32_t>& sleepers) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0) futex_wake(word, INT_MAX);
+    }
+};
+
+// SpinFutex с ограниченным сном: после каждого таймаута (Watch::POLL) вызывается Watch::check().
+// Нужен, когда партнёр - другой процесс: если он умер, разбудить нас некому, и check() должна
+// это обнаружить (и завершить программу), а не оставить нас на futex навсегда.
+template <class Watch>
+struct SpinFutexWatched : SpinFutex {
+    static void wait(std::atomic<uint32_t>& word, uint32_t seen, std::atomic<uint32_t>& sleepers) {
+        for (int i = 0, n = spin_limit(); i < n; ++i) {
+            if (word.load(std::memory_order_acquire) != seen) return;
+            cpu_relax();
+        }
+        while (word.load(std::memory_order_acquire) == seen) {
+            sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (word.load(std::memory_order_relaxed) == seen) futex_wait(word, seen, &Watch::POLL);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            if (word.load(std::memory_order_acquire) == seen) Watch::check();
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+};
+
+} // namespace wait_policy
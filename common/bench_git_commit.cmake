@@ -0,0 +1,19 @@
+# Запускается при каждой сборке (cmake -P): пишет OUTPUT с BENCH_GIT_COMMIT для bench_harness.h.
+# Файл перезаписывается только при смене коммита, иначе зависимые исходники не пересобираются.
+#   cmake -DSOURCE_DIR=<исходники> -DOUTPUT=<.../bench_git_commit.h> -P bench_git_commit.cmake
+execute_process(COMMAND git describe --always --dirty
+                WORKING_DIRECTORY ${SOURCE_DIR}
+                OUTPUT_VARIABLE commit
+                OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(NOT commit)
+    set(commit "unknown")
+endif()
+
+set(content "#pragma once\n#define BENCH_GIT_COMMIT \"${commit}\"\n")
+set(old_content "")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old_content)
+endif()
+if(NOT content STREQUAL old_content)
+    file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -0,0 +1,345 @@
+#pragma once
+// Общая обвязка замеров для Lab_1 и Lab_2: прогрев, повторы, статистика, структурированный вывод.
+//   bench::Config cfg = bench::parse_args(argc, argv); // забирает флаги харнесса из argv
+//   bench::Reporter rep("parallel_sort", cfg);
+//   const bench::Params point = {{"size", "1000000"}, {"threads", "4"}};
+//   auto samples = bench::run(cfg, [&] { ...; return time_ms; }, point); // fn сама мерит нужный участок
+//   bench::Stats st = rep.add("parallel", point, samples);
+//   auto series = bench::run_multi(cfg, [&] { ...; return bench::Metrics{{"latency", us}, {"throughput", gbps}}; }, point);
+//   rep.add("latency", point, series["latency"], "us");
+//   rep.write(); // JSON или CSV в файл --out (если задан)
+// Флаги (остальные аргументы программы не трогаются):
+//   --warmup N     прогревочных запусков, не входят в статистику (по умолчанию 1)
+//   --reps N       измеряемых повторов (по умолчанию 5)
+//   --outliers K   отбрасывать замеры дальше K*MAD от медианы (по умолчанию 3, 0 - не отбрасывать;
+//                  действует от 5 повторов)
+//   --format F     json | csv (по умолчанию - по расширению --out, иначе json)
+//   --out FILE     куда писать результаты с метаданными
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "perf_counters.h" // метки областей по точкам развёртки и повторам
+
+#if defined(__linux__) || defined(__APPLE__)
+    #include <unistd.h> // gethostname
+#endif
+
+#if __has_include("bench_git_commit.h")
+    #include "bench_git_commit.h" // генерируется CMake на каждой сборке (git describe --always --dirty)
+#endif
+#ifndef BENCH_GIT_COMMIT
+    #define BENCH_GIT_COMMIT "unknown" // сборка без CMake
+#endif
+
+namespace bench {
+
+struct Config {
+    int warmup = 1;
+    int reps = 5;
+    double outlier_k = 3.0;
+    std::string format = "json";
+    std::string out;
+};
+
+// Разбор и удаление флагов харнесса из argv; позиционные аргументы программы сдвигаются к началу
+inline Config parse_args(int& argc, char** argv) {
+    Config cfg;
+    bool format_given = false;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--warmup" && has_value) cfg.warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--reps" && has_value) cfg.reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--outliers" && has_value) cfg.outlier_k = std::atof(argv[++i]);
+        else if (arg == "--format" && has_value) { cfg.format = argv[++i]; format_given = true; }
+        else if (arg == "--out" && has_value) cfg.out = argv[++i];
+        else argv[kept++] = argv[i];
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+    if (!format_given && cfg.out.size() >= 4 && cfg.out.compare(cfg.out.size() - 4, 4, ".csv") == 0) cfg.format = "csv";
+    return cfg;
+}
+
+// "1,2,4" -> {1,2,4}: список значений для развёртки параметра внутри одного процесса.
+// Пустой вектор, если значений нет ("", ",") или какое-то не разбирается - вызывающий печатает usage
+template <class T>
+std::vector<T> parse_list(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        std::stringstream conv(item);
+        T v{};
+        char rest;
+        if (!(conv >> v) || (conv >> rest)) return {};
+        values.push_back(v);
+    }
+    return values;
+}
+
+struct Stats {
+    size_t n = 0;        // замеров после отбраковки
+    size_t rejected = 0; // отброшено выбросов
+    double min = 0, max = 0, median = 0, mean = 0, stddev = 0;
+    double ci95 = 0;     // полуширина 95% доверительного интервала среднего (t-распределение)
+};
+
+inline double median_of(std::vector<double> v) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t m = v.size() / 2;
+    return (v.size() % 2) ? v[m] : 0.5 * (v[m - 1] + v[m]);
+}
+
+// Квантиль t-распределения Стьюдента 0.975 для df степеней свободы
+inline double t_975(size_t df) {
+    static const double table[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) return 0;
+    return df <= 30 ? table[df] : 1.96;
+}
+
+// Статистика с отбраковкой выбросов по медианному абсолютному отклонению (MAD)
+inline Stats compute_stats(const std::vector<double>& samples, double outlier_k) {
+    Stats st;
+    std::vector<double> kept = samples;
+    if (outlier_k > 0 && samples.size() >= 5) { // на меньшем числе замеров MAD ненадёжна
+        const double med = median_of(samples);
+        std::vector<double> dev;
+        for (double x : samples) dev.push_back(std::fabs(x - med));
+        const double mad = 1.4826 * median_of(dev); // оценка sigma для нормального распределения
+        if (mad > 0) {
+            kept.clear();
+            for (double x : samples) if (std::fabs(x - med) <= outlier_k * mad) kept.push_back(x);
+        }
+    }
+    st.n = kept.size();
+    st.rejected = samples.size() - kept.size();
+    if (kept.empty()) return st;
+    st.min = *std::min_element(kept.begin(), kept.end());
+    st.max = *std::max_element(kept.begin(), kept.end());
+    st.median = median_of(kept);
+    for (double x : kept) st.mean += x;
+    st.mean /= kept.size();
+    if (kept.size() > 1) {
+        double ss = 0;
+        for (double x : kept) ss += (x - st.mean) * (x - st.mean);
+        st.stddev = std::sqrt(ss / (kept.size() - 1));
+        st.ci95 = t_975(kept.size() - 1) * st.stddev / std::sqrt(double(kept.size()));
+    }
+    return st;
+}
+
+using Params = std::vector<std::pair<std::string, std::string>>;
+
+// {{"size", "1000"}, {"threads", "2"}} -> "size=1000 threads=2"
+inline std::string params_label(const Params& params) {
+    std::string label;
+    for (const auto& kv : params) label += (label.empty() ? "" : " ") + kv.first + "=" + kv.second;
+    return label;
+}
+
+// Прогрев + повторы; record получает результат каждого измеряемого запуска.
+// point - параметры точки развёртки: ими и номером повтора помечаются области perf::Region
+// (области прогрева не записываются)
+template <class F, class Record>
+void repeat(const Config& cfg, const Params& point, F&& fn, Record&& record) {
+    const std::string label = params_label(point);
+    for (int i = 0; i < cfg.warmup; ++i) {
+        perf::set_point(label, i, true);
+        fn();
+    }
+    for (int i = 0; i < cfg.reps; ++i) {
+        perf::set_point(label, i, false);
+        record(fn());
+    }
+    perf::clear_point();
+}
+
+// fn возвращает замер одного запуска (обычно время в мс)
+template <class F>
+std::vector<double> run(const Config& cfg, F&& fn, const Params& point = {}) {
+    std::vector<double> samples;
+    repeat(cfg, point, fn, [&](double value) { samples.push_back(value); });
+    return samples;
+}
+
+// Несколько величин одного запуска: {{"latency", 3.2}, {"throughput", 1.1}}
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+// Замеры нескольких величин: по вектору на имя, в порядке первого появления
+class Series {
+    std::vector<std::pair<std::string, std::vector<double>>> columns;
+
+public:
+    void append(const Metrics& metrics) {
+        for (const auto& kv : metrics) {
+            auto it = std::find_if(columns.begin(), columns.end(), [&](const auto& c) { return c.first == kv.first; });
+            if (it == columns.end()) it = columns.insert(columns.end(), {kv.first, {}});
+            it->second.push_back(kv.second);
+        }
+    }
+
+    // Замеры величины name (пусто, если fn её не возвращала)
+    const std::vector<double>& operator[](const std::string& name) const {
+        static const std::vector<double> empty;
+        for (const auto& c : columns) if (c.first == name) return c.second;
+        return empty;
+    }
+};
+
+// Как run, но fn возвращает Metrics: каждая величина собирается в свой ряд (прогрев не входит)
+template <class F>
+Series run_multi(const Config& cfg, F&& fn, const Params& point = {}) {
+    Series series;
+    repeat(cfg, point, fn, [&](const Metrics& metrics) { series.append(metrics); });
+    return series;
+}
+
+inline std::string cpu_model() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(" \t", colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+inline std::string host_name() {
+#if defined(__linux__) || defined(__APPLE__)
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf) - 1) == 0) return buf;
+#endif
+    const char* env = std::getenv("COMPUTERNAME");
+    return env ? env : "unknown";
+}
+
+inline std::string to_text(double value) {
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+inline std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    return out;
+}
+
+inline std::string csv_escape(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char c : s) { if (c == '"') out += '"'; out += c; }
+    return out + "\"";
+}
+
+// Собирает результаты и пишет их вместе с метаданными запуска
+class Reporter {
+    struct Record {
+        std::string name;
+        Params params;
+        std::string unit;
+        Stats stats;
+        std::vector<double> samples;
+    };
+
+    std::string program;
+    Config cfg;
+    Params metadata;
+    std::vector<Record> records;
+
+public:
+    Reporter(std::string program_, Config cfg_) : program(std::move(program_)), cfg(std::move(cfg_)) {
+        std::time_t now = std::time(nullptr);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        metadata = {{"program", program}, {"git_commit", BENCH_GIT_COMMIT}, {"timestamp", stamp},
+                    {"hostname", host_name()}, {"cpu_model", cpu_model()},
+                    {"hardware_threads", std::to_string(std::thread::hardware_concurrency())},
+                    {"warmup", std::to_string(cfg.warmup)}, {"reps", std::to_string(cfg.reps)},
+                    {"outlier_k", to_text(cfg.outlier_k)}};
+    }
+
+    // Дополнительные метаданные (например, число MPI-рангов или размещение потоков)
+    void set_meta(const std::string& key, const std::string& value) {
+        for (auto& kv : metadata) if (kv.first == key) { kv.second = value; return; }
+        metadata.emplace_back(key, value);
+    }
+
+    // Статистика по замерам + строка "STATS:" в stdout; unit - единица замеров (по умолчанию мс)
+    Stats add(const std::string& name, const Params& params, const std::vector<double>& samples, const std::string& unit = "ms") {
+        Stats st = compute_stats(samples, cfg.outlier_k);
+        records.push_back({name, params, unit, st, samples});
+        std::cout << "STATS: " << name;
+        for (const auto& kv : params) std::cout << " " << kv.first << "=" << kv.second;
+        std::cout << " n=" << st.n << " rejected=" << st.rejected << " min=" << st.min << " median=" << st.median
+                  << " mean=" << st.mean << " stddev=" << st.stddev << " ci95=" << st.ci95 << " " << unit << std::endl;
+        return st;
+    }
+
+    void write() const {
+        if (cfg.out.empty()) return;
+        std::ofstream out(cfg.out);
+        if (!out.is_open()) { std::cerr << "bench: cannot open " << cfg.out << std::endl; return; }
+        out.precision(9);
+        if (cfg.format == "csv") write_csv(out); else write_json(out);
+    }
+
+private:
+    void write_json(std::ostream& out) const {
+        out << "{\n  \"metadata\": {";
+        for (size_t i = 0; i < metadata.size(); ++i)
+            out << (i ? ", " : "") << "\"" << json_escape(metadata[i].first) << "\": \"" << json_escape(metadata[i].second) << "\"";
+        out << "},\n  \"results\": [";
+        for (size_t r = 0; r < records.size(); ++r) {
+            const Record& rec = records[r];
+            out << (r ? "," : "") << "\n    {\"name\": \"" << json_escape(rec.name) << "\", \"params\": {";
+            for (size_t i = 0; i < rec.params.size(); ++i)
+                out << (i ? ", " : "") << "\"" << json_escape(rec.params[i].first) << "\": \"" << json_escape(rec.params[i].second) << "\"";
+            const Stats& st = rec.stats;
+            out << "}, \"unit\": \"" << json_escape(rec.unit) << "\", \"n\": " << st.n << ", \"rejected\": " << st.rejected << ", \"min\": " << st.min
+                << ", \"max\": " << st.max << ", \"median\": " << st.median << ", \"mean\": " << st.mean
+                << ", \"stddev\": " << st.stddev << ", \"ci95\": " << st.ci95 << ", \"samples\": [";
+            for (size_t i = 0; i < rec.samples.size(); ++i) out << (i ? ", " : "") << rec.samples[i];
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    // Одна строка на результат; метаданные повторяются в каждой строке, параметры - "k=v;k=v"
+    void write_csv(std::ostream& out) const {
+        for (const auto& kv : metadata) out << csv_escape(kv.first) << ",";
+        out << "name,params,unit,n,rejected,min,max,median,mean,stddev,ci95\n";
+        for (const Record& rec : records) {
+            for (const auto& kv : metadata) out << csv_escape(kv.second) << ",";
+            std::string params;
+            for (size_t i = 0; i < rec.params.size(); ++i) params += (i ? ";" : "") + rec.params[i].first + "=" + rec.params[i].second;
+            const Stats& st = rec.stats;
+            out << csv_escape(rec.name) << "," << csv_escape(params) << "," << csv_escape(rec.unit) << "," << st.n << "," << st.rejected << "," << st.min << ","
+                << st.max << "," << st.median << "," << st.mean << "," << st.stddev << "," << st.ci95 << "\n";
+        }
+    }
+};
+
+} // namespace bench
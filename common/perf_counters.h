@@ -0,0 +1,253 @@
+#pragma once
+// Аппаратные счётчики через perf_event_open для Lab_1 и Lab_2.
+//   perf::Region r("solve");   // RAII: считает от конструктора до деструктора в текущем потоке
+//   ...
+//   perf::report(std::cout);   // в конце программы: таблица по областям и потокам
+// Области внутри bench::run помечаются точкой развёртки и номером повтора (perf::set_point);
+// области прогревочных запусков не записываются. Номера потоков считаются заново в каждом повторе.
+// На поток открываются счётчики cycles, instructions, LLC misses, branch misses, context switches
+// (один раз, при первой области в этом потоке). Если ядро не разрешает perf (perf_event_paranoid,
+// контейнер, не Linux) или LAB_PERF=0 - остаётся только время, вместо значений пишется n/a.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace perf {
+
+enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, CONTEXT_SWITCHES, NUM_EVENTS };
+const char* const EVENT_NAMES[NUM_EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses", "ctx_switches"};
+
+// Результат одной области в одном потоке; -1 - счётчик недоступен
+struct Sample {
+    std::string region;
+    std::string point; // параметры точки развёртки ("size=1000 threads=2"), пусто - вне bench::run
+    int rep;           // номер повтора, -1 - вне bench::run
+    int thread;
+    double time_ms;
+    int64_t values[NUM_EVENTS];
+};
+
+// Общее состояние: собранные области и причина, по которой счётчики недоступны
+struct Registry {
+    std::mutex mtx;
+    std::vector<Sample> samples;
+    std::string unavailable; // причина первого неоткрывшегося счётчика
+    bool any_opened = false; // хотя бы один счётчик хотя бы в одном потоке
+    int next_thread = 0;     // в текущем повторе
+    int generation = 0;      // меняется при каждом set_point: потоки получают номера заново
+    std::string point;
+    int rep = -1;
+    bool warmup = false;
+
+    static Registry& instance() { static Registry r; return r; }
+};
+
+inline bool enabled_by_env() {
+    const char* env = std::getenv("LAB_PERF");
+    return !(env && std::strcmp(env, "0") == 0);
+}
+
+// Счётчики текущего потока: открываются при первом обращении, считают непрерывно до выхода потока
+class ThreadCounters {
+    int fds[NUM_EVENTS];
+    int index = 0;
+    int generation = -1;
+
+#if defined(__linux__)
+    static int open_event(uint32_t type, uint64_t config, std::string& error) {
+        for (int exclude_kernel = 0; exclude_kernel <= 1; ++exclude_kernel) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.exclude_kernel = exclude_kernel; // без прав - только пользовательский режим
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            long fd = syscall(__NR_perf_event_open, &attr, 0 /* этот поток */, -1 /* любой CPU */, -1, 0);
+            if (fd >= 0) return static_cast<int>(fd);
+            error = std::string("perf_event_open: ") + std::strerror(errno);
+            if (errno != EACCES && errno != EPERM) break;
+        }
+        return -1;
+    }
+#endif
+
+    void open_all() {
+        std::fill(fds, fds + NUM_EVENTS, -1);
+        std::string error = "LAB_PERF=0";
+#if defined(__linux__)
+        if (enabled_by_env()) {
+            fds[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, error);
+            fds[INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, error);
+            fds[LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, error); // обычно LLC
+            fds[BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, error);
+            fds[CONTEXT_SWITCHES] = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, error);
+        }
+#else
+        error = "perf_event_open is Linux-only";
+#endif
+        Registry& reg = Registry::instance();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        for (int fd : fds) {
+            if (fd >= 0) reg.any_opened = true;
+            else if (reg.unavailable.empty()) reg.unavailable = error;
+        }
+    }
+
+    void close_all() {
+#if defined(__linux__)
+        for (int& fd : fds) if (fd >= 0) { close(fd); fd = -1; }
+#endif
+    }
+
+public:
+    ThreadCounters() { open_all(); }
+    ~ThreadCounters() { close_all(); }
+
+    // После fork: унаследованные дескрипторы считают поток родителя
+    void reopen() {
+        close_all();
+        open_all();
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    // Номер потока в текущем повторе (по порядку первой области); вызывать под Registry::mtx
+    int thread_index(Registry& reg) {
+        if (generation != reg.generation) {
+            generation = reg.generation;
+            index = reg.next_thread++;
+        }
+        return index;
+    }
+
+    // Текущие значения (с поправкой на мультиплексирование), -1 для недоступных
+    void read(int64_t out[NUM_EVENTS]) const {
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            out[e] = -1;
+#if defined(__linux__)
+            uint64_t buf[3]; // value, time_enabled, time_running
+            if (fds[e] < 0 || ::read(fds[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+            out[e] = (buf[2] > 0 && buf[2] < buf[1]) ? static_cast<int64_t>(double(buf[0]) * buf[1] / buf[2]) : static_cast<int64_t>(buf[0]);
+#endif
+        }
+    }
+
+    static ThreadCounters& current() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+};
+
+// Текущая точка развёртки и повтор (ставит bench::run); warmup - области не записываются
+inline void set_point(const std::string& point, int rep, bool warmup) {
+    Registry& reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    reg.point = point;
+    reg.rep = rep;
+    reg.warmup = warmup;
+    ++reg.generation;
+    reg.next_thread = 0;
+}
+
+inline void clear_point() { set_point("", -1, false); }
+
+// Замеряемая область: разность счётчиков и времени между конструктором и деструктором
+class Region {
+    Sample s;
+    bool skip; // область прогревочного запуска
+    ThreadCounters& counters;
+    int64_t start_values[NUM_EVENTS];
+    std::chrono::steady_clock::time_point start_time;
+
+public:
+    explicit Region(std::string name_) : counters(ThreadCounters::current()) {
+        s.region = std::move(name_);
+        {
+            Registry& reg = Registry::instance();
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            s.point = reg.point;
+            s.rep = reg.rep;
+            s.thread = counters.thread_index(reg);
+            skip = reg.warmup;
+        }
+        counters.read(start_values);
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    ~Region() {
+        auto end_time = std::chrono::steady_clock::now();
+        counters.read(s.values);
+        if (skip) return;
+        s.time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        for (int e = 0; e < NUM_EVENTS; ++e) s.values[e] = (s.values[e] < 0 || start_values[e] < 0) ? -1 : s.values[e] - start_values[e];
+        Registry& reg = Registry::instance();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        reg.samples.push_back(std::move(s));
+    }
+
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+};
+
+// В потомке fork (вызывать сразу после него, пока процесс однопоточный): счётчики текущего потока
+// открыты для потока родителя, а собранные области - копия родительских. Счётчики открываются заново,
+// области отбрасываются; точка развёртки и повтор (set_point) сохраняются
+inline void after_fork() {
+    ThreadCounters::current().reopen();
+    Registry& reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    reg.samples.clear();
+}
+
+// Только строки областей, без строки о недоступных счётчиках (например, для сбора из потомков)
+inline void report_samples(std::ostream& out, const std::string& prefix = "") {
+    Registry& reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    const std::string head = prefix.empty() ? "PERF: " : "PERF: " + prefix + " ";
+    const std::streamsize old_precision = out.precision();
+    for (const Sample& s : reg.samples) {
+        out << head << s.region;
+        if (!s.point.empty()) out << " " << s.point;
+        if (s.rep >= 0) out << " rep=" << s.rep;
+        out << " thread=" << s.thread << " time_ms=" << std::fixed << std::setprecision(3) << s.time_ms;
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            out << " " << EVENT_NAMES[e] << "=";
+            if (s.values[e] < 0) out << "n/a"; else out << s.values[e];
+        }
+        if (s.values[CYCLES] > 0 && s.values[INSTRUCTIONS] >= 0)
+            out << " ipc=" << std::setprecision(2) << double(s.values[INSTRUCTIONS]) / s.values[CYCLES];
+        out << std::defaultfloat << std::setprecision(old_precision) << std::endl;
+    }
+}
+
+// Вывод всех закрытых областей строками "PERF: ..." (prefix - например, "rank 3")
+inline void report(std::ostream& out, const std::string& prefix = "") {
+    {
+        Registry& reg = Registry::instance();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        const std::string head = prefix.empty() ? "PERF: " : "PERF: " + prefix + " ";
+        if (!reg.unavailable.empty())
+            out << head << "counters unavailable (" << reg.unavailable << ")" << (reg.any_opened ? ", shown as n/a" : ", timing only") << std::endl;
+    }
+    report_samples(out, prefix);
+}
+
+} // namespace perf
@@ -0,0 +1,37 @@
+#pragma once
+// Вывод счётчиков всех MPI-рангов (см. perf_counters.h).
+//   perf::report_ordered(MPI_COMM_WORLD); // коллективный вызов, в конце программы до MPI_Finalize
+// Каждый ранг форматирует свои строки "PERF: rank N ...", ранг 0 собирает их и печатает по порядку рангов:
+// вывод разных процессов через mpirun иначе перемешивается даже при поочерёдной печати с барьерами.
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "perf_counters.h"
+
+namespace perf {
+
+inline void report_ordered(MPI_Comm comm, std::ostream& out = std::cout) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    std::ostringstream local;
+    report(local, "rank " + std::to_string(rank));
+    const std::string text = local.str();
+    int length = static_cast<int>(text.size());
+
+    std::vector<int> lengths(rank == 0 ? size : 0), offsets(rank == 0 ? size : 0);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+    std::string all;
+    if (rank == 0) {
+        int total = 0;
+        for (int r = 0; r < size; ++r) { offsets[r] = total; total += lengths[r]; }
+        all.resize(total);
+    }
+    MPI_Gatherv(text.data(), length, MPI_CHAR, rank == 0 ? &all[0] : nullptr, lengths.data(), offsets.data(), MPI_CHAR, 0, comm);
+    if (rank == 0) out << all << std::flush;
+}
+
+} // namespace perf
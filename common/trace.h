@@ -0,0 +1,253 @@
+#pragma once
+// Трассировка событий для Lab_1 и Lab_2 с выгрузкой в формат Chrome trace (chrome://tracing, ui.perfetto.dev).
+//   TRACE_SCOPE("compute");          // RAII: begin в конструкторе, end в деструкторе
+//   TRACE_BEGIN("halo"); ... TRACE_END("halo");
+//   TRACE_COUNTER("tasks_left", n);  // значение счётчика во времени
+//   trace::write("integral_pthread"); // в конце программы (MPI - trace::mpi_write из trace_mpi.h)
+// Включается переменной LAB_TRACE: путь к файлу JSON или "1" (тогда trace.json).
+// Без LAB_TRACE каждый макрос - одна проверка закэшированного флага; -DLAB_NO_TRACE убирает их совсем.
+// Имена событий - строковые литералы: хранится только указатель.
+// У каждого потока своё кольцо (до LAB_TRACE_EVENTS событий, по умолчанию 65536): пишет только владелец,
+// без блокировок; память выделяется блоками по CHUNK_EVENTS событий по мере записи (короткоживущие потоки
+// повторов не занимают полного кольца, записанные события никогда не копируются); при переполнении
+// затираются самые старые события.
+// При выгрузке пары B/E выравниваются: E без своего B (B затёрт) отбрасывается, незакрытый B
+// закрывается временем последнего события потока.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+const size_t DEFAULT_EVENTS = size_t(1) << 16;
+const size_t CHUNK_EVENTS = size_t(1) << 12; // блок кольца: новый блок выделяется, старые остаются на месте
+
+struct Event {
+    const char* name;
+    int64_t ts_ns;  // от trace::epoch()
+    double value;   // для счётчиков
+    char phase;     // 'B', 'E', 'C' - как в формате Chrome
+};
+
+// Настройки из окружения, читаются один раз
+struct Settings {
+    bool enabled = false;
+    std::string path;
+    size_t capacity = DEFAULT_EVENTS;
+
+    static const Settings& get() {
+        static const Settings s = [] {
+            Settings r;
+            const char* env = std::getenv("LAB_TRACE");
+            if (env && *env && std::strcmp(env, "0") != 0) {
+                r.enabled = true;
+                r.path = (std::strcmp(env, "1") == 0) ? "trace.json" : env;
+            }
+            if (const char* events = std::getenv("LAB_TRACE_EVENTS")) {
+                long long n = std::atoll(events);
+                if (n > 0) r.capacity = static_cast<size_t>(n);
+            }
+            return r;
+        }();
+        return s;
+    }
+};
+
+inline bool enabled() {
+    static const bool on = Settings::get().enabled;
+    return on;
+}
+
+inline std::chrono::steady_clock::time_point epoch() {
+    static const auto t0 = std::chrono::steady_clock::now();
+    return t0;
+}
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+// Кольцо одного потока: писатель - сам поток, читатель - write() после завершения рабочих потоков
+class ThreadBuffer {
+    std::vector<std::unique_ptr<Event[]>> chunks; // capacity / chunk_events блоков, выделяются при первой записи
+    size_t capacity;
+    size_t mask;
+    size_t chunk_events;
+    int chunk_shift;
+    std::atomic<uint64_t> head{0}; // всего записано событий
+
+    Event& slot(uint64_t i) const { const size_t s = i & mask; return chunks[s >> chunk_shift][s & (chunk_events - 1)]; }
+
+public:
+    const int index;
+    std::string name;
+
+    ThreadBuffer(size_t capacity_, int index_) : index(index_) {
+        size_t rounded = 1;
+        while (rounded < capacity_) rounded <<= 1;
+        capacity = rounded;
+        mask = rounded - 1;
+        chunk_events = std::min(capacity, CHUNK_EVENTS);
+        chunk_shift = 0;
+        while ((size_t(1) << chunk_shift) < chunk_events) ++chunk_shift;
+        chunks.resize(capacity / chunk_events); // только указатели
+    }
+
+    void record(const char* name_, char phase, double value = 0) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        const Event e = {name_, now_ns(), value, phase};
+        const size_t s = h & mask;
+        if ((s & (chunk_events - 1)) == 0 && !chunks[s >> chunk_shift]) // читатель смотрит блоки только после завершения потока
+            chunks[s >> chunk_shift].reset(new Event[chunk_events]);
+        slot(h) = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    uint64_t written() const { return head.load(std::memory_order_acquire); }
+    uint64_t dropped() const { uint64_t h = written(); return h > capacity ? h - capacity : 0; }
+
+    // Сохранившиеся события в порядке записи
+    template <class F>
+    void for_each(F&& fn) const {
+        const uint64_t h = written();
+        for (uint64_t i = dropped(); i < h; ++i) fn(slot(i));
+    }
+};
+
+// Все кольца процесса; владеет ими, чтобы события переживали свои потоки
+struct Registry {
+    std::mutex mtx; // только при регистрации потока и при выгрузке
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    static Registry& instance() { static Registry r; return r; }
+};
+
+inline ThreadBuffer& current() {
+    thread_local ThreadBuffer* buffer = [] {
+        Registry& reg = Registry::instance();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>(Settings::get().capacity, static_cast<int>(reg.buffers.size())));
+        return reg.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+inline void begin(const char* name) { if (enabled()) current().record(name, 'B'); }
+inline void end(const char* name) { if (enabled()) current().record(name, 'E'); }
+inline void counter(const char* name, double value) { if (enabled()) current().record(name, 'C', value); }
+
+// Имя потока в просмотрщике (по умолчанию "thread N")
+inline void set_thread_name(const std::string& name) { if (enabled()) current().name = name; }
+
+class Scope {
+    const char* name;
+
+public:
+    explicit Scope(const char* name_) : name(name_) { begin(name); }
+    ~Scope() { end(name); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+inline void json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+        else out += c;
+    }
+    out += '"';
+}
+
+// События процесса как объекты JSON через запятую; ts в мкс = ts_ns / 1000 + shift_us
+inline std::string events_json(int pid, const std::string& process_name, double shift_us = 0) {
+    Registry& reg = Registry::instance();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    std::string out;
+    char buf[96];
+    auto sep = [&out] { if (!out.empty()) out += ",\n"; };
+
+    sep();
+    out += "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" + std::to_string(pid) + ",\"args\":{\"name\":";
+    json_string(out, process_name);
+    out += "}}";
+    for (const auto& tb : reg.buffers) {
+        sep();
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + std::to_string(pid) + ",\"tid\":" + std::to_string(tb->index) + ",\"args\":{\"name\":";
+        json_string(out, tb->name.empty() ? "thread " + std::to_string(tb->index) : tb->name);
+        out += "}}";
+        if (tb->dropped() > 0)
+            std::cerr << "trace: " << process_name << " thread " << tb->index << " dropped " << tb->dropped()
+                      << " oldest events (LAB_TRACE_EVENTS)" << std::endl;
+        auto emit = [&](const Event& e) {
+            sep();
+            out += "{\"ph\":\"";
+            out += e.phase;
+            out += "\",\"name\":";
+            json_string(out, e.name);
+            std::snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"pid\":%d,\"tid\":%d", e.ts_ns / 1000.0 + shift_us, pid, tb->index);
+            out += buf;
+            if (e.phase == 'C') {
+                std::snprintf(buf, sizeof(buf), ",\"args\":{\"value\":%.17g}", e.value);
+                out += buf;
+            }
+            out += '}';
+        };
+        std::vector<const char*> open; // незакрытые B этого потока
+        int64_t last_ts = 0;
+        tb->for_each([&](const Event& e) {
+            last_ts = e.ts_ns;
+            if (e.phase == 'B') open.push_back(e.name);
+            else if (e.phase == 'E') {
+                if (open.empty()) return; // B затёрт при переполнении кольца
+                open.pop_back();
+            }
+            emit(e);
+        });
+        while (!open.empty()) {
+            emit({open.back(), last_ts, 0, 'E'});
+            open.pop_back();
+        }
+    }
+    return out;
+}
+
+inline bool write_file(const std::string& path, const std::string& events) {
+    std::ofstream out(path);
+    if (!out.is_open()) { std::cerr << "trace: cannot open " << path << std::endl; return false; }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" << events << "\n]}\n";
+    std::cout << "TRACE: " << path << std::endl;
+    return true;
+}
+
+// Однопроцессная выгрузка в файл из LAB_TRACE (вызывать после завершения рабочих потоков)
+inline void write(const std::string& process_name) {
+    if (!enabled()) return;
+    write_file(Settings::get().path, events_json(0, process_name));
+}
+
+} // namespace trace
+
+#ifdef LAB_NO_TRACE
+    #define TRACE_SCOPE(name)
+    #define TRACE_BEGIN(name)
+    #define TRACE_END(name)
+    #define TRACE_COUNTER(name, value)
+#else
+    #define TRACE_CONCAT_IMPL(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+    #define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+    #define TRACE_BEGIN(name) trace::begin(name)
+    #define TRACE_END(name) trace::end(name)
+    #define TRACE_COUNTER(name, value) trace::counter(name, value)
+#endif
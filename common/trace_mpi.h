@@ -0,0 +1,98 @@
+#pragma once
+// Сборка трасс всех MPI-рангов в один файл Chrome trace (см. trace.h).
+//   trace::mpi_write(MPI_COMM_WORLD, "task1_3_2"); // коллективный вызов, в конце программы до MPI_Finalize
+// Каждый ранг - отдельный процесс в просмотрщике (pid = ранг). Часы выравниваются по рангу 0:
+// steady_clock ранга -> MPI_Wtime ранга -> MPI_Wtime ранга 0 (смещение по пинг-понгу с минимальным RTT,
+// если MPI_WTIME_IS_GLOBAL не выставлен). Файл пишет ранг 0.
+#include <mpi.h>
+#include <limits>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+namespace trace {
+
+const int CLOCK_SYNC_ROUNDS = 16;
+const int CLOCK_SYNC_TAG = 7301;
+
+// Смещение (с), которое надо прибавить к MPI_Wtime этого ранга, чтобы получить MPI_Wtime ранга 0
+inline double mpi_wtime_offset(MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int* is_global = nullptr;
+    int found = 0;
+    MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_WTIME_IS_GLOBAL, &is_global, &found);
+    if (found && is_global && *is_global) return 0.0;
+
+    // Ранг 0 по очереди отвечает каждому рангу своим временем; берётся обмен с самым коротким RTT
+    double offset = 0.0;
+    for (int peer = 1; peer < size; ++peer) {
+        if (rank == 0) {
+            for (int r = 0; r < CLOCK_SYNC_ROUNDS; ++r) {
+                char ping;
+                MPI_Recv(&ping, 1, MPI_CHAR, peer, CLOCK_SYNC_TAG, comm, MPI_STATUS_IGNORE);
+                double t_root = MPI_Wtime();
+                MPI_Send(&t_root, 1, MPI_DOUBLE, peer, CLOCK_SYNC_TAG, comm);
+            }
+        } else if (rank == peer) {
+            double best_rtt = std::numeric_limits<double>::max();
+            for (int r = 0; r < CLOCK_SYNC_ROUNDS; ++r) {
+                char ping = 0;
+                double t_root = 0;
+                double t0 = MPI_Wtime();
+                MPI_Send(&ping, 1, MPI_CHAR, 0, CLOCK_SYNC_TAG, comm);
+                MPI_Recv(&t_root, 1, MPI_DOUBLE, 0, CLOCK_SYNC_TAG, comm, MPI_STATUS_IGNORE);
+                double t1 = MPI_Wtime();
+                if (t1 - t0 < best_rtt) {
+                    best_rtt = t1 - t0;
+                    offset = t_root - 0.5 * (t0 + t1);
+                }
+            }
+        }
+    }
+    return offset;
+}
+
+// Коллективная выгрузка: события всех рангов собираются на ранге 0 (MPI_Gatherv) и пишутся в LAB_TRACE
+inline void mpi_write(MPI_Comm comm, const std::string& program) {
+    if (!enabled()) return; // LAB_TRACE одинаков у всех рангов одного mpirun
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    // Момент steady_clock этого ранга в шкале MPI_Wtime ранга 0 (мкс); отсчёт от самого раннего ранга
+    const double offset = mpi_wtime_offset(comm);
+    const int64_t steady = now_ns();
+    const double wtime_us = (MPI_Wtime() + offset) * 1e6;
+    double shift_us = wtime_us - steady / 1000.0;
+    double min_shift_us = 0;
+    MPI_Allreduce(&shift_us, &min_shift_us, 1, MPI_DOUBLE, MPI_MIN, comm);
+    shift_us -= min_shift_us;
+
+    const std::string local = events_json(rank, program + " rank " + std::to_string(rank), shift_us);
+    int local_bytes = static_cast<int>(local.size());
+    std::vector<int> counts(size), displs(size);
+    MPI_Gather(&local_bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+
+    std::vector<char> all;
+    if (rank == 0) {
+        int total = 0;
+        for (int r = 0; r < size; ++r) { displs[r] = total; total += counts[r]; }
+        all.resize(total);
+    }
+    MPI_Gatherv(local.data(), local_bytes, MPI_CHAR, all.data(), counts.data(), displs.data(), MPI_CHAR, 0, comm);
+
+    if (rank == 0) {
+        std::string events;
+        for (int r = 0; r < size; ++r) {
+            if (counts[r] == 0) continue;
+            if (!events.empty()) events += ",\n";
+            events.append(all.data() + displs[r], counts[r]);
+        }
+        write_file(Settings::get().path, events);
+    }
+}
+
+} // namespace trace